@@ -1,2 +1,5 @@
-glslc shaders/simple_shader.vert -o shaders/simple_shader.vert.spv
-glslc shaders/simple_shader.frag -o shaders/simple_shader.frag.spv
\ No newline at end of file
+# .spv for the override directory, .inc embedded by lard_shader_registry.cpp
+for shader in shaders/*.vert shaders/*.frag shaders/*.comp; do
+  glslc "$shader" -o "$shader.spv"
+  glslc -mfmt=num "$shader" -o "$shader.inc"
+done
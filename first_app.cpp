@@ -1,5 +1,6 @@
 #include "first_app.hpp"
 #include "simple_render_system.hpp"
+#include "lard_attachment_pool.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -8,31 +9,471 @@
 
 #include <array>
 #include <cassert>
+#include <chrono>
+#include <iostream>
 #include <stdexcept>
+#include <tuple>
 
 
 namespace lard {
-    FirstApp::FirstApp() {
+    static void sierpinski(
+        std::vector<LardModel::Vertex>& vertices,
+        int depth,
+        glm::vec2 left,
+        glm::vec2 right,
+        glm::vec2 top) {
+        if (depth <= 0) {
+            vertices.push_back({ top, { 1.0f, 0.0f, 0.0f } });
+            vertices.push_back({ right, { 0.0f, 1.0f, 0.0f } });
+            vertices.push_back({ left, { 0.0f, 0.0f, 1.0f } });
+        } else {
+            auto leftTop = 0.5f * (left + top);
+            auto rightTop = 0.5f * (right + top);
+            auto leftRight = 0.5f * (left + right);
+            sierpinski(vertices, depth - 1, left, leftRight, leftTop);
+            sierpinski(vertices, depth - 1, leftRight, right, rightTop);
+            sierpinski(vertices, depth - 1, leftTop, rightTop, top);
+        }
+    }
+
+    FirstApp::FirstApp(bool headless, LardFrameProfile profile)
+        : lardWindow{ headless ? nullptr : std::make_unique<LardWindow>(WIDTH, HEIGHT, "Hello Vulkan!") },
+        lardRenderer{ lardWindow.get(), lardDevice, { WIDTH, HEIGHT }, profile } {
         loadGameObjects();
     }
 
     FirstApp::~FirstApp() {}
 
     void FirstApp::run() {
-        SimpleRenderSystem simpleRenderSystem{ lardDevice, lardRenderer.getSwapChainRenderPass() };
-        while (!lardWindow.shouldClose()) {
-            glfwPollEvents();
-            if (auto commandBuffer = lardRenderer.beginFrame()) {
+        // the first frames only clear until the pipeline has compiled
+        SimpleRenderSystem simpleRenderSystem{ lardDevice, lardRenderer.getSwapChainRenderTarget(), pipelineRegistry, false };
+        bool profileKeyDown = false;
+        bool variantKeyDown = false;
+        while (!lardWindow->shouldClose()) {
+            // the renderer skips frames while minimized, sleep until something happens instead
+            auto extent = lardWindow->getExtent();
+            if (extent.width == 0 || extent.height == 0) {
+                glfwWaitEvents();
+            } else {
+                glfwPollEvents();
+            }
+
+            // L switches between the low latency and high throughput frame profiles
+            bool keyDown = glfwGetKey(lardWindow->getGLFWwindow(), GLFW_KEY_L) == GLFW_PRESS;
+            if (keyDown && !profileKeyDown) {
+                bool lowLatency = lardRenderer.getFrameProfile() == LardFrameProfile::LowLatency;
+                lardRenderer.setFrameProfile(lowLatency ? LardFrameProfile::HighThroughput : LardFrameProfile::LowLatency);
+            }
+            profileKeyDown = keyDown;
+
+            // V toggles between push constant and vertex colors, a specialized shader variant
+            keyDown = glfwGetKey(lardWindow->getGLFWwindow(), GLFW_KEY_V) == GLFW_PRESS;
+            if (keyDown && !variantKeyDown) {
+                simpleRenderSystem.setVariant(simpleRenderSystem.getVariant() ^ SimpleRenderSystem::VARIANT_VERTEX_COLOR);
+            }
+            variantKeyDown = keyDown;
+
+            drawFrame(simpleRenderSystem, entities);
+        }
+
+        vkDeviceWaitIdle(lardDevice.device());
+
+    }
+
+    // Renders the scene offscreen as fast as the device allows, no presentation engine caps it.
+    void FirstApp::runHeadless(int frameCount) {
+        SimpleRenderSystem simpleRenderSystem{ lardDevice, lardRenderer.getSwapChainRenderTarget(), pipelineRegistry };
+
+        int frames = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        while (frames < frameCount) {
+            if (drawFrame(simpleRenderSystem, entities)) {
+                frames++;
+            }
+        }
+        vkDeviceWaitIdle(lardDevice.device());
+        double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "headless: " << frames << " frames in " << seconds << " s, "
+            << frames / seconds << " frames/s" << std::endl;
+    }
+
+    bool FirstApp::drawFrame(SimpleRenderSystem& simpleRenderSystem, LardEntityStore& objects) {
+        if (auto commandBuffer = lardRenderer.beginFrame()) {
+            auto recordStart = std::chrono::steady_clock::now();
+            LardCommandRecorder* recorder = parallelRecording ? &lardRenderer.getCommandRecorder() : nullptr;
+            LardFrameAllocator* instanceAllocator = instancing ? &lardRenderer.getFrameAllocator() : nullptr;
+            uint32_t frameIndex = static_cast<uint32_t>(lardRenderer.getFrameIndex());
+            if (gpuDriven) {
+                // the dispatch has to be recorded outside of any render pass instance
+                {
+                    LardProfileScope scope{ lardRenderer.getProfiler(), commandBuffer, "cull" };
+                    simpleRenderSystem.cullGameObjects(commandBuffer, frameIndex, lardRenderer.getFrameAllocator(), objects);
+                }
+                if (lardRenderer.supportsRenderGraph()) {
+                    simpleRenderSystem.addIndirectRenderPass(
+                        lardRenderer.getRenderGraph(),
+                        lardRenderer.getSwapChainColor(),
+                        lardRenderer.getSwapChainDepth(),
+                        lardRenderer.getClearColor(),
+                        objects);
+                    lardRenderer.executeRenderGraph(commandBuffer);
+                } else {
+                    lardRenderer.beginSwapChainRenderPass(commandBuffer);
+                    simpleRenderSystem.renderGameObjectsIndirect(commandBuffer, objects);
+                    lardRenderer.endSwapChainRenderPass(commandBuffer);
+                }
+            } else if (staticScene && lardRenderer.supportsRenderGraph()) {
+                simpleRenderSystem.addStaticRenderPass(
+                    lardRenderer.getRenderGraph(),
+                    lardRenderer.getSwapChainColor(),
+                    lardRenderer.getSwapChainDepth(),
+                    lardRenderer.getClearColor(),
+                    frameIndex,
+                    objects);
+                lardRenderer.executeRenderGraph(commandBuffer);
+            } else if (staticScene) {
+                lardRenderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                simpleRenderSystem.renderStaticGameObjects(commandBuffer, frameIndex, lardRenderer.getSwapChainInheritance(), objects);
+                lardRenderer.endSwapChainRenderPass(commandBuffer);
+            } else if (lardRenderer.supportsRenderGraph()) {
+                simpleRenderSystem.addRenderPass(
+                    lardRenderer.getRenderGraph(),
+                    lardRenderer.getSwapChainColor(),
+                    lardRenderer.getSwapChainDepth(),
+                    lardRenderer.getClearColor(),
+                    objects,
+                    recorder,
+                    instanceAllocator);
+                lardRenderer.executeRenderGraph(commandBuffer);
+            } else if (recorder != nullptr) {
+                lardRenderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                simpleRenderSystem.renderGameObjectsParallel(
+                    *recorder, commandBuffer, lardRenderer.getSwapChainInheritance(), objects, instanceAllocator);
+                lardRenderer.endSwapChainRenderPass(commandBuffer);
+            } else {
                 lardRenderer.beginSwapChainRenderPass(commandBuffer);
-                simpleRenderSystem.renderGameObjects(commandBuffer, gameObjects);
+                {
+                    LardProfileScope scope{ lardRenderer.getProfiler(), commandBuffer, "simple render system" };
+                    simpleRenderSystem.renderGameObjects(commandBuffer, objects, instanceAllocator);
+                }
                 lardRenderer.endSwapChainRenderPass(commandBuffer);
-                lardRenderer.endFrame();
             }
+            recordingSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - recordStart).count();
+            lardRenderer.endFrame();
+            return true;
+        }
+        return false;
+    }
+
+    // Draws the same vertex heavy scene with host visible and with device local vertex buffers,
+    // then welded into an indexed model. Presentation may cap all runs at the refresh rate when
+    // MAILBOX is not available.
+    void FirstApp::runVertexPlacementBenchmark(int frameCount) {
+        SimpleRenderSystem simpleRenderSystem{ lardDevice, lardRenderer.getSwapChainRenderTarget(), pipelineRegistry };
+
+        std::vector<LardModel::Vertex> vertices{};
+        sierpinski(vertices, 8, { -0.5f, 0.5f }, { 0.5f, 0.5f }, { 0.0f, -0.5f });
+        constexpr int objectCount = 64;
+
+        LardModel::Builder welded{ vertices };
+        std::cout << "welding: " << vertices.size() << " vertices -> " << welded.vertices.size()
+            << " vertices and " << welded.indices.size() << " indices" << std::endl;
+
+        const std::tuple<LardModel::Placement, bool, const char*> placements[] = {
+            { LardModel::Placement::HostVisible, false, "host visible" },
+            { LardModel::Placement::DeviceLocal, false, "device local" },
+            { LardModel::Placement::DeviceLocal, true, "device local indexed" },
+        };
+        for (const auto& [placement, indexed, name] : placements) {
+            auto lardModel = indexed
+                ? std::make_shared<LardModel>(lardDevice, welded, placement)
+                : std::make_shared<LardModel>(lardDevice, vertices, placement);
+            LardEntityStore objects;
+            for (int i = 0; i < objectCount; i++) {
+                auto object = LardGameObject::createGameObject();
+                object.model = lardModel;
+                object.color = { .1f, .8f, .1f };
+                object.transform2d.scale = glm::vec2(.5f) + i * 0.01f;
+                object.transform2d.rotation = i * glm::pi<float>() * .025f;
+                objects.add(std::move(object));
+            }
+
+            // warm up, this also flushes the staging ring before timing starts
+            for (int i = 0; i < 10; i++) {
+                pollEvents();
+                drawFrame(simpleRenderSystem, objects);
+            }
+            vkDeviceWaitIdle(lardDevice.device());
 
+            int frames = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            while (frames < frameCount && !shouldClose()) {
+                pollEvents();
+                if (drawFrame(simpleRenderSystem, objects)) {
+                    frames++;
+                }
+            }
+            vkDeviceWaitIdle(lardDevice.device());
+            double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            double vertexRate = static_cast<double>(vertices.size()) * objectCount * frames / seconds;
+            std::cout << name << " vertex buffers: " << frames / seconds << " frames/s, "
+                << vertexRate / 1e6 << " Mvertices/s" << std::endl;
         }
+    }
 
-        vkDeviceWaitIdle(lardDevice.device());
+    // Runs the scene with both frame profiles and reports throughput next to input-to-present
+    // latency, which one wins depends on the GPU, the driver and the display.
+    void FirstApp::runLatencyBenchmark(int frameCount) {
+        SimpleRenderSystem simpleRenderSystem{ lardDevice, lardRenderer.getSwapChainRenderTarget(), pipelineRegistry };
+
+        const std::pair<LardFrameProfile, const char*> profiles[] = {
+            { LardFrameProfile::LowLatency, "low latency" },
+            { LardFrameProfile::HighThroughput, "high throughput" },
+        };
+        for (const auto& [profile, name] : profiles) {
+            lardRenderer.setFrameProfile(profile);
+            for (int i = 0; i < 10; i++) {
+                pollEvents();
+                drawFrame(simpleRenderSystem, entities);
+            }
+            vkDeviceWaitIdle(lardDevice.device());
+            lardRenderer.resetLatencyStats();
+
+            int frames = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            while (frames < frameCount && !shouldClose()) {
+                pollEvents();
+                if (drawFrame(simpleRenderSystem, entities)) {
+                    frames++;
+                }
+            }
+            vkDeviceWaitIdle(lardDevice.device());
+            double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            auto latency = lardRenderer.getLatencyStats();
+            std::cout << name << ": " << frames / seconds << " frames/s, input to present "
+                << latency.averageMs << " ms average, " << latency.maxMs << " ms max over "
+                << latency.frameCount << " frames" << std::endl;
+        }
+    }
+
+    // Records a scene with many draws serially, split over the recorder's threads and once into
+    // cached static buffers, and reports the CPU time spent recording per frame. The static run
+    // does not animate the objects, GPU time is otherwise the same in all runs.
+    void FirstApp::runRecordingBenchmark(int frameCount) {
+        SimpleRenderSystem simpleRenderSystem{ lardDevice, lardRenderer.getSwapChainRenderTarget(), pipelineRegistry };
+
+        constexpr int objectCount = 20000;
+        LardEntityStore objects;
+        for (int i = 0; i < objectCount; i++) {
+            auto object = LardGameObject::createGameObject();
+            object.model = triangleModel;
+            object.color = { .1f, .8f, .1f };
+            object.transform2d.translation = { (i % 200) / 100.0f - 1.0f, (i / 200) / 50.0f - 1.0f };
+            object.transform2d.scale = glm::vec2(.02f);
+            objects.add(std::move(object));
+        }
+
+        // serial, parallel, static
+        for (int mode = 0; mode < 3; mode++) {
+            parallelRecording = mode == 1;
+            staticScene = mode == 2;
+            for (int i = 0; i < 10; i++) {
+                pollEvents();
+                drawFrame(simpleRenderSystem, objects);
+            }
+            vkDeviceWaitIdle(lardDevice.device());
+            recordingSeconds = 0.0;
+
+            int frames = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            while (frames < frameCount && !shouldClose()) {
+                pollEvents();
+                if (drawFrame(simpleRenderSystem, objects)) {
+                    frames++;
+                }
+            }
+            vkDeviceWaitIdle(lardDevice.device());
+            double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            if (parallelRecording) {
+                std::cout << "parallel (" << lardRenderer.getCommandRecorder().threadCount() << " threads)";
+            } else if (staticScene) {
+                std::cout << "static";
+            } else {
+                std::cout << "serial";
+            }
+            std::cout << ": " << objectCount << " draws recorded in " << recordingSeconds * 1000.0 / frames
+                << " ms per frame, " << frames / seconds << " frames/s" << std::endl;
+        }
+        if (staticScene) {
+            auto stats = simpleRenderSystem.getStaticStats();
+            std::cout << "static: " << stats.recordCount << " recordings, " << stats.reuseCount << " reuses" << std::endl;
+        }
+        parallelRecording = false;
+        staticScene = false;
+    }
+
+    // Draws objectCount objects sharing one model with a draw per object and with one instanced
+    // draw, and reports CPU recording time per frame along with the frame rate.
+    void FirstApp::runInstancingBenchmark(int frameCount, int objectCount) {
+        SimpleRenderSystem simpleRenderSystem{ lardDevice, lardRenderer.getSwapChainRenderTarget(), pipelineRegistry };
+
+        LardEntityStore objects;
+        for (int i = 0; i < objectCount; i++) {
+            auto object = LardGameObject::createGameObject();
+            object.model = triangleModel;
+            object.color = { (i % 7) / 7.0f, .8f, (i % 13) / 13.0f };
+            object.transform2d.translation = { (i % 400) / 200.0f - 1.0f, ((i / 400) % 400) / 200.0f - 1.0f };
+            object.transform2d.scale = glm::vec2(.01f);
+            objects.add(std::move(object));
+        }
+
+        bool wasInstancing = instancing;
+        for (bool instanced : { false, true }) {
+            instancing = instanced;
+            // also lets the instanced pipeline compile before measuring
+            for (int i = 0; i < 10; i++) {
+                pollEvents();
+                drawFrame(simpleRenderSystem, objects);
+            }
+            pipelineCompiler.waitIdle();
+            vkDeviceWaitIdle(lardDevice.device());
+            recordingSeconds = 0.0;
+
+            int frames = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            while (frames < frameCount && !shouldClose()) {
+                pollEvents();
+                if (drawFrame(simpleRenderSystem, objects)) {
+                    frames++;
+                }
+            }
+            vkDeviceWaitIdle(lardDevice.device());
+            double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            std::cout << (instanced ? "instanced" : "per object") << ": " << objectCount << " objects recorded in "
+                << recordingSeconds * 1000.0 / frames << " ms per frame, " << frames / seconds << " frames/s" << std::endl;
+        }
+        instancing = wasInstancing;
+    }
+
+    // Draws growing numbers of objects from the CPU one by one and GPU driven, animated and culled
+    // by compute shaders and drawn with indirect count draws. Recording time of the GPU driven
+    // path must not grow with the object count.
+    void FirstApp::runGpuDrivenBenchmark(int frameCount) {
+        SimpleRenderSystem simpleRenderSystem{ lardDevice, lardRenderer.getSwapChainRenderTarget(), pipelineRegistry };
+        if (!lardDevice.hasIndirectCount()) {
+            std::cout << "gpu driven: not supported by this device" << std::endl;
+            return;
+        }
+
+        bool wasGpuDriven = gpuDriven;
+        for (int objectCount : { 10000, 50000, 200000 }) {
+            // a third of the objects lies outside the viewport and gets culled
+            LardEntityStore objects;
+            for (int i = 0; i < objectCount; i++) {
+                auto object = LardGameObject::createGameObject();
+                object.model = triangleModel;
+                object.color = { (i % 7) / 7.0f, .8f, (i % 13) / 13.0f };
+                object.transform2d.translation = { (i % 500) / 200.0f - 1.25f, ((i / 500) % 500) / 200.0f - 1.25f };
+                object.transform2d.scale = glm::vec2(.01f);
+                object.animation.rotationSpeed = 1.0f + (i % 5) * .5f;
+                object.animation.swayAmplitude = { .02f, .01f * (i % 3) };
+                object.animation.swaySpeed = 2.0f + (i % 7) * .3f;
+                object.animation.pulseAmount = .2f;
+                object.animation.pulseSpeed = 3.0f;
+                objects.add(std::move(object));
+            }
+
+            for (bool gpu : { false, true }) {
+                gpuDriven = gpu;
+                // also lets the culling and drawing pipelines compile before measuring
+                for (int i = 0; i < 10; i++) {
+                    pollEvents();
+                    drawFrame(simpleRenderSystem, objects);
+                }
+                pipelineCompiler.waitIdle();
+                vkDeviceWaitIdle(lardDevice.device());
+                recordingSeconds = 0.0;
+
+                int frames = 0;
+                auto start = std::chrono::high_resolution_clock::now();
+                while (frames < frameCount && !shouldClose()) {
+                    pollEvents();
+                    if (drawFrame(simpleRenderSystem, objects)) {
+                        frames++;
+                    }
+                }
+                vkDeviceWaitIdle(lardDevice.device());
+                double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+                std::cout << (gpu ? "gpu driven" : "per object") << ": " << objectCount << " objects recorded in "
+                    << recordingSeconds * 1000.0 / frames << " ms per frame, " << frames / seconds << " frames/s" << std::endl;
+            }
+        }
+        gpuDriven = wasGpuDriven;
+    }
 
+    // Pipeline creation is what the on-disk pipeline cache speeds up, run once without and once
+    // with pipeline_cache.bin to compare cold and warm startup.
+    void FirstApp::runStartupReport(double constructionSeconds) {
+        auto start = std::chrono::steady_clock::now();
+        SimpleRenderSystem simpleRenderSystem{ lardDevice, lardRenderer.getSwapChainRenderTarget(), pipelineRegistry, false };
+        double submitSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        pipelineCompiler.waitIdle();
+        double pipelineSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        // an identical system shares the first one's pipeline instead of compiling its own
+        SimpleRenderSystem sharedRenderSystem{ lardDevice, lardRenderer.getSwapChainRenderTarget(), pipelineRegistry };
+
+        std::cout << "startup (" << (lardDevice.isPipelineCacheWarm() ? "warm" : "cold") << " pipeline cache): "
+            << constructionSeconds * 1000.0 << " ms device and swap chain, "
+            << pipelineSeconds * 1000.0 << " ms pipelines ("
+            << submitSeconds * 1000.0 << " ms blocking the frame loop), "
+            << (constructionSeconds + pipelineSeconds) * 1000.0 << " ms total" << std::endl;
+        lardDevice.printFeatures(std::cout);
+        pipelineRegistry.printStats(std::cout);
+        lardDevice.allocator().printStats(std::cout);
+    }
+
+    void FirstApp::runAttachmentReport() {
+        constexpr double MiB = 1024.0 * 1024.0;
+
+        std::cout << "swap chain ";
+        lardRenderer.getSwapChainAttachments().printStats(std::cout);
+
+        auto imageCount = lardRenderer.getSwapChainImageCount();
+        int framesInFlight = lardRenderer.getFramesInFlight();
+        const VkExtent2D extents[] = { { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 }, { 7680, 4320 } };
+        for (const auto& extent : extents) {
+            LardAttachmentDesc desc{};
+            desc.format = lardRenderer.getSwapChainRenderTarget().depthFormat;
+            desc.extent = extent;
+            desc.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            desc.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+            // what createDepthResources used to do: one device local image per swap chain image
+            LardAttachmentPool perImage{ lardDevice, false };
+            for (size_t i = 0; i < imageCount; i++) {
+                perImage.request(desc);
+            }
+            perImage.build();
+
+            LardAttachmentPool perFrame{ lardDevice };
+            for (int i = 0; i < framesInFlight; i++) {
+                perFrame.request(desc);
+            }
+            perFrame.build();
+
+            const auto& before = perImage.getStats();
+            const auto& after = perFrame.getStats();
+            std::cout << extent.width << "x" << extent.height << ": "
+                << imageCount << " depth images " << before.boundBytes / MiB << " MiB -> "
+                << framesInFlight << " depth images " << after.boundBytes / MiB << " MiB ("
+                << after.lazyBytes / MiB << " MiB lazily allocated), saved "
+                << (before.boundBytes - after.boundBytes) / MiB << " MiB" << std::endl;
+        }
     }
 
     void FirstApp::loadGameObjects() {
@@ -47,16 +488,18 @@ namespace lard {
         //std::vector<LardModel::Vertex> vertices{};
         //sierpinski(vertices, 5, {-0.5f, 0.5f}, {0.5f, 0.5f}, {0.0f, -0.5f});
 
-        auto lardModel = std::make_shared<LardModel>(lardDevice, vertices);
+        triangleModel = std::make_shared<LardModel>(lardDevice, vertices);
 
         auto triangle = LardGameObject::createGameObject();
-        triangle.model = lardModel;
+        triangle.model = triangleModel;
         triangle.color = { .1f, .8f, .1f };
         triangle.transform2d.translation.x = .2f;
         triangle.transform2d.scale = { 2.f, .5f };
         triangle.transform2d.rotation = .25f * glm::two_pi<float>(); // radian
+        // GPU driven mode, about the pace of the CPU animation at 60 frames/s
+        triangle.animation.rotationSpeed = .066f;
 
-        gameObjects.push_back(std::move(triangle));
+        entities.add(std::move(triangle));
 
         /*
          std::vector<LardModel::Vertex> vertices{
@@ -81,7 +524,7 @@ namespace lard {
              triangle.transform2d.scale = glm::vec2(.5f) + i * 0.025f;
              triangle.transform2d.rotation = i * glm::pi<float>() * .025f;
              triangle.color = colors[i % colors.size()];
-             gameObjects.push_back(std::move(triangle));
+             entities.add(std::move(triangle));
          }
          */
     }
@@ -1,30 +1,76 @@
 #pragma once
 
+#include <iostream>
 #include <memory>
 #include <vector>
 
 #include "lard_window.hpp"
-#include "lard_game_object.hpp"
+#include "lard_entity_store.hpp"
 #include "lard_device.hpp"
 #include "lard_renderer.hpp"
+#include "lard_pipeline_registry.hpp"
 
 namespace lard {
+    class SimpleRenderSystem;
+
     class FirstApp {
     public:
-        FirstApp();
+        // headless renders offscreen without GLFW, e.g. on lavapipe or a render server
+        explicit FirstApp(bool headless = false, LardFrameProfile profile = LardFrameProfile::HighThroughput);
         ~FirstApp();
         FirstApp(const FirstApp&) = delete;
         FirstApp& operator=(const FirstApp&) = delete;
         static constexpr int WIDTH = 800;
         static constexpr int HEIGHT = 600;
 
+        // prints averaged GPU scope timings every frameInterval frames
+        void setProfilerSummaryInterval(uint32_t frameInterval) {
+            lardRenderer.getProfiler().setSummaryInterval(frameInterval, std::cout);
+        }
+
         void run();
+        void runHeadless(int frameCount);
+        void runVertexPlacementBenchmark(int frameCount);
+        void runLatencyBenchmark(int frameCount);
+        void runRecordingBenchmark(int frameCount);
+        void runInstancingBenchmark(int frameCount, int objectCount);
+        void runGpuDrivenBenchmark(int frameCount);
+        // draws are recorded into secondary command buffers on worker threads
+        void setParallelRecording(bool enabled) { parallelRecording = enabled; }
+        // the scene is not animated and its draws are recorded once and re-executed
+        void setStaticScene(bool enabled) { staticScene = enabled; }
+        // objects sharing a model are drawn with one instanced draw
+        void setInstancing(bool enabled) { instancing = enabled; }
+        // objects are culled by a compute shader and drawn with indirect count draws, when the
+        // device supports it; takes precedence over the other drawing modes
+        void setGpuDriven(bool enabled) { gpuDriven = enabled; }
+        // constructionSeconds is how long constructing the app took, pipelines are timed here;
+        // also prints the device features, pipeline registry and device memory allocator stats
+        void runStartupReport(double constructionSeconds);
+        // depth memory of one image per swap chain image against the attachment pool's layout
+        void runAttachmentReport();
     private:
         void loadGameObjects();
+        bool shouldClose() { return lardWindow != nullptr && lardWindow->shouldClose(); }
+        void pollEvents() {
+            if (lardWindow != nullptr) {
+                glfwPollEvents();
+            }
+        }
+        bool drawFrame(SimpleRenderSystem& simpleRenderSystem, LardEntityStore& objects);
+
+        std::unique_ptr<LardWindow> lardWindow;  // null when running headless
+        LardDevice lardDevice{ lardWindow.get() };
+        LardPipelineCompiler pipelineCompiler{ lardDevice };
+        LardPipelineRegistry pipelineRegistry{ lardDevice, pipelineCompiler };
+        LardRenderer lardRenderer;
+        LardEntityStore entities;
+        std::shared_ptr<LardModel> triangleModel;  // shared with the benchmark scenes
 
-        LardWindow lardWindow{ WIDTH, HEIGHT, "Hello Vulkan!" };
-        LardDevice lardDevice{ lardWindow };
-        LardRenderer lardRenderer{ lardWindow, lardDevice };
-        std::vector<LardGameObject> gameObjects;
+        bool parallelRecording = false;
+        bool staticScene = false;
+        bool instancing = false;
+        bool gpuDriven = false;
+        double recordingSeconds = 0.0;  // CPU time spent recording draws
     };
 }
\ No newline at end of file
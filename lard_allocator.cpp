@@ -0,0 +1,307 @@
+#include "lard_allocator.hpp"
+
+// std headers
+#include <algorithm>
+#include <set>
+#include <stdexcept>
+
+namespace lard {
+
+    // One VkDeviceMemory object. Non-dedicated blocks are power of two sized and split with a
+    // buddy scheme: a free range of order n covers MIN_ALLOCATION_SIZE << n bytes and its offset
+    // is a multiple of its own size, so any power of two alignment up to that size is implied.
+    class LardMemoryBlock {
+    public:
+        bool allocate(uint32_t order, VkDeviceSize& offset);
+        void free(VkDeviceSize offset, uint32_t order);
+
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize size = 0;
+        void* mappedData = nullptr;
+        uint32_t memoryTypeIndex = 0;
+        bool linear = true;
+        bool dedicated = false;
+
+        uint32_t allocationCount = 0;
+        VkDeviceSize allocatedBytes = 0;
+        VkDeviceSize requestedBytes = 0;
+
+        uint32_t maxOrder = 0;
+        std::vector<std::set<VkDeviceSize>> freeLists;
+    };
+
+    static uint32_t orderForSize(VkDeviceSize size) {
+        uint32_t order = 0;
+        while ((LardAllocator::MIN_ALLOCATION_SIZE << order) < size) {
+            order++;
+        }
+        return order;
+    }
+
+    bool LardMemoryBlock::allocate(uint32_t order, VkDeviceSize& offset) {
+        uint32_t current = order;
+        while (current <= maxOrder && freeLists[current].empty()) {
+            current++;
+        }
+        if (current > maxOrder) {
+            return false;
+        }
+
+        // lowest offset first keeps live ranges packed at the start of the block
+        offset = *freeLists[current].begin();
+        freeLists[current].erase(freeLists[current].begin());
+
+        while (current > order) {
+            current--;
+            freeLists[current].insert(offset + (LardAllocator::MIN_ALLOCATION_SIZE << current));
+        }
+        return true;
+    }
+
+    void LardMemoryBlock::free(VkDeviceSize offset, uint32_t order) {
+        while (order < maxOrder) {
+            VkDeviceSize buddy = offset ^ (LardAllocator::MIN_ALLOCATION_SIZE << order);
+            auto it = freeLists[order].find(buddy);
+            if (it == freeLists[order].end()) {
+                break;
+            }
+            freeLists[order].erase(it);
+            offset = std::min(offset, buddy);
+            order++;
+        }
+        freeLists[order].insert(offset);
+    }
+
+    LardAllocator::LardAllocator(VkDevice device, VkPhysicalDevice physicalDevice) : device{ device } {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        maxMemoryAllocationCount = properties.limits.maxMemoryAllocationCount;
+    }
+
+    LardAllocator::~LardAllocator() {
+        for (auto& pool : pools) {
+            for (auto& block : pool) {
+                destroyBlock(*block);
+            }
+            pool.clear();
+        }
+    }
+
+    uint32_t LardAllocator::matchMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) &&
+                (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+        return NO_MEMORY_TYPE;
+    }
+
+    uint32_t LardAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+        uint32_t memoryTypeIndex = matchMemoryType(typeFilter, properties);
+        if (memoryTypeIndex == NO_MEMORY_TYPE) {
+            throw std::runtime_error("failed to find suitable memory type!");
+        }
+        return memoryTypeIndex;
+    }
+
+    bool LardAllocator::hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+        return matchMemoryType(typeFilter, properties) != NO_MEMORY_TYPE;
+    }
+
+    VkDeviceSize LardAllocator::preferredBlockSize(uint32_t memoryTypeIndex) const {
+        uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[heapIndex].size;
+
+        // an eighth of the heap, rounded down to a power of two, between 1 MiB and MAX_BLOCK_SIZE
+        VkDeviceSize blockSize = 1024 * 1024;
+        while (blockSize * 2 <= heapSize / 8 && blockSize * 2 <= MAX_BLOCK_SIZE) {
+            blockSize *= 2;
+        }
+        return blockSize;
+    }
+
+    std::unique_ptr<LardMemoryBlock> LardAllocator::createBlock(
+        uint32_t memoryTypeIndex, VkDeviceSize size, bool linear, bool dedicated) {
+        if (memoryAllocationCount >= maxMemoryAllocationCount) {
+            throw std::runtime_error("maxMemoryAllocationCount exceeded!");
+        }
+
+        auto block = std::make_unique<LardMemoryBlock>();
+        block->size = size;
+        block->memoryTypeIndex = memoryTypeIndex;
+        block->linear = linear;
+        block->dedicated = dedicated;
+
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate device memory block!");
+        }
+        memoryAllocationCount++;
+
+        if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            if (vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mappedData) != VK_SUCCESS) {
+                vkFreeMemory(device, block->memory, nullptr);
+                memoryAllocationCount--;
+                throw std::runtime_error("failed to map device memory block!");
+            }
+        }
+
+        if (!dedicated) {
+            block->maxOrder = orderForSize(size);
+            block->freeLists.resize(block->maxOrder + 1);
+            block->freeLists[block->maxOrder].insert(0);
+        }
+        return block;
+    }
+
+    void LardAllocator::destroyBlock(LardMemoryBlock& block) {
+        if (block.mappedData != nullptr) {
+            vkUnmapMemory(device, block.memory);
+        }
+        vkFreeMemory(device, block.memory, nullptr);
+        memoryAllocationCount--;
+    }
+
+    LardAllocation LardAllocator::allocate(
+        const VkMemoryRequirements& requirements,
+        VkMemoryPropertyFlags properties,
+        bool linear) {
+        std::lock_guard<std::mutex> lock{ mutex };
+
+        uint32_t memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+        VkDeviceSize blockSize = preferredBlockSize(memoryTypeIndex);
+        VkDeviceSize needed = std::max(requirements.size, requirements.alignment);
+        Pool& pool = getPool(memoryTypeIndex, linear);
+
+        LardAllocation allocation{};
+        allocation.memoryTypeIndex = memoryTypeIndex;
+        allocation.size = requirements.size;
+
+        LardMemoryBlock* target = nullptr;
+        if (needed > blockSize / 2) {
+            // a buddy block would waste up to half of itself on this, give it its own memory
+            pool.push_back(createBlock(memoryTypeIndex, requirements.size, linear, true));
+            target = pool.back().get();
+            target->allocatedBytes += requirements.size;
+        } else {
+            allocation.order = orderForSize(needed);
+            for (auto& block : pool) {
+                if (!block->dedicated && block->allocate(allocation.order, allocation.offset)) {
+                    target = block.get();
+                    break;
+                }
+            }
+            if (target == nullptr) {
+                pool.push_back(createBlock(memoryTypeIndex, blockSize, linear, false));
+                target = pool.back().get();
+                target->allocate(allocation.order, allocation.offset);
+            }
+            target->allocatedBytes += MIN_ALLOCATION_SIZE << allocation.order;
+        }
+        target->allocationCount++;
+        target->requestedBytes += requirements.size;
+
+        allocation.block = target;
+        allocation.memory = target->memory;
+        if (target->mappedData != nullptr) {
+            allocation.mappedData = static_cast<char*>(target->mappedData) + allocation.offset;
+        }
+        return allocation;
+    }
+
+    void LardAllocator::free(LardAllocation& allocation) {
+        if (allocation.block == nullptr) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock{ mutex };
+
+        LardMemoryBlock* block = allocation.block;
+        block->allocationCount--;
+        block->requestedBytes -= allocation.size;
+        if (block->dedicated) {
+            block->allocatedBytes -= allocation.size;
+        } else {
+            block->allocatedBytes -= MIN_ALLOCATION_SIZE << allocation.order;
+            block->free(allocation.offset, allocation.order);
+        }
+        allocation = LardAllocation{};
+
+        if (block->allocationCount > 0) {
+            return;
+        }
+
+        // keep a single empty block per pool so a free/allocate pattern does not thrash the driver
+        Pool& pool = getPool(block->memoryTypeIndex, block->linear);
+        bool keep = !block->dedicated && std::none_of(pool.begin(), pool.end(), [block](const auto& other) {
+            return other.get() != block && !other->dedicated && other->allocationCount == 0;
+        });
+        if (!keep) {
+            auto it = std::find_if(pool.begin(), pool.end(), [block](const auto& other) {
+                return other.get() == block;
+            });
+            destroyBlock(*block);
+            pool.erase(it);
+        }
+    }
+
+    void LardAllocator::trim() {
+        std::lock_guard<std::mutex> lock{ mutex };
+
+        for (auto& pool : pools) {
+            auto empty = std::stable_partition(pool.begin(), pool.end(), [](const auto& block) {
+                return block->allocationCount > 0;
+            });
+            for (auto it = empty; it != pool.end(); it++) {
+                destroyBlock(**it);
+            }
+            pool.erase(empty, pool.end());
+        }
+    }
+
+    std::vector<LardAllocator::HeapStats> LardAllocator::getHeapStats() {
+        std::lock_guard<std::mutex> lock{ mutex };
+
+        std::vector<HeapStats> stats(memoryProperties.memoryHeapCount);
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+            stats[i].heapSize = memoryProperties.memoryHeaps[i].size;
+        }
+
+        for (auto& pool : pools) {
+            for (auto& block : pool) {
+                auto& heap = stats[memoryProperties.memoryTypes[block->memoryTypeIndex].heapIndex];
+                heap.blockCount++;
+                heap.allocationCount += block->allocationCount;
+                heap.blockBytes += block->size;
+                heap.allocatedBytes += block->allocatedBytes;
+                heap.requestedBytes += block->requestedBytes;
+            }
+        }
+        return stats;
+    }
+
+    void LardAllocator::printStats(std::ostream& out) {
+        constexpr double MiB = 1024.0 * 1024.0;
+
+        auto stats = getHeapStats();
+        out << "device memory (" << memoryAllocationCount << "/" << maxMemoryAllocationCount
+            << " allocations):" << std::endl;
+        for (size_t i = 0; i < stats.size(); i++) {
+            const auto& heap = stats[i];
+            out << "\theap " << i
+                << ((memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " (device local)" : "")
+                << ": " << heap.blockCount << " blocks, " << heap.allocationCount << " allocations, "
+                << heap.requestedBytes / MiB << " MiB requested, "
+                << heap.allocatedBytes / MiB << " MiB allocated, "
+                << heap.blockBytes / MiB << " MiB reserved of "
+                << heap.heapSize / MiB << " MiB" << std::endl;
+        }
+    }
+
+}  // namespace lard
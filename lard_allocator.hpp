@@ -0,0 +1,92 @@
+#pragma once
+
+// vulkan headers
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <array>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace lard {
+
+    class LardMemoryBlock;
+
+    // A sub-range of a device memory block. Host visible memory is persistently mapped,
+    // mappedData points at the start of this range in that case.
+    struct LardAllocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void* mappedData = nullptr;
+        uint32_t memoryTypeIndex = 0;
+
+        // allocator bookkeeping
+        LardMemoryBlock* block = nullptr;
+        uint32_t order = 0;
+    };
+
+    // Keeps a few large VkDeviceMemory blocks per memory type and hands out aligned
+    // sub-ranges with a buddy scheme. Buffers (linear) and optimal tiling images never share
+    // a block so bufferImageGranularity does not have to be honoured inside a block.
+    class LardAllocator {
+    public:
+        static constexpr VkDeviceSize MIN_ALLOCATION_SIZE = 256;
+        static constexpr VkDeviceSize MAX_BLOCK_SIZE = 256ull * 1024 * 1024;
+
+        struct HeapStats {
+            VkDeviceSize heapSize = 0;
+            uint32_t blockCount = 0;
+            uint32_t allocationCount = 0;
+            VkDeviceSize blockBytes = 0;      // device memory reserved from the heap
+            VkDeviceSize allocatedBytes = 0;  // bytes handed out, including buddy rounding
+            VkDeviceSize requestedBytes = 0;  // bytes actually asked for
+        };
+
+        LardAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+        ~LardAllocator();
+        LardAllocator(const LardAllocator&) = delete;
+        LardAllocator& operator=(const LardAllocator&) = delete;
+
+        LardAllocation allocate(
+            const VkMemoryRequirements& requirements,
+            VkMemoryPropertyFlags properties,
+            bool linear);
+        void free(LardAllocation& allocation);
+
+        // Releases every block that has no live allocation left. Freed ranges are merged with
+        // their buddies eagerly and at most one empty block per pool is kept around, so this is
+        // only needed to give memory back to the driver after a level unload.
+        void trim();
+
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+        bool hasMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+        std::vector<HeapStats> getHeapStats();
+        void printStats(std::ostream& out);
+
+    private:
+        using Pool = std::vector<std::unique_ptr<LardMemoryBlock>>;
+
+        static constexpr uint32_t NO_MEMORY_TYPE = UINT32_MAX;
+
+        Pool& getPool(uint32_t memoryTypeIndex, bool linear) {
+            return pools[memoryTypeIndex * 2 + (linear ? 0 : 1)];
+        }
+        // NO_MEMORY_TYPE if none matches
+        uint32_t matchMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+        VkDeviceSize preferredBlockSize(uint32_t memoryTypeIndex) const;
+        std::unique_ptr<LardMemoryBlock> createBlock(
+            uint32_t memoryTypeIndex, VkDeviceSize size, bool linear, bool dedicated);
+        void destroyBlock(LardMemoryBlock& block);
+
+        VkDevice device;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        uint32_t maxMemoryAllocationCount;
+        uint32_t memoryAllocationCount = 0;
+        std::array<Pool, VK_MAX_MEMORY_TYPES * 2> pools;
+        std::mutex mutex;
+    };
+
+}  // namespace lard
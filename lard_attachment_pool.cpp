@@ -0,0 +1,181 @@
+#include "lard_attachment_pool.hpp"
+
+// std headers
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <stdexcept>
+
+namespace lard {
+
+    static bool isTransientUsage(VkImageUsageFlags usage) {
+        constexpr VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT |
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+        return usage != 0 && (usage & ~attachmentUsage) == 0;
+    }
+
+    LardAttachmentPool::LardAttachmentPool(LardDevice& device, bool allowLazyAllocation)
+        : lardDevice{ device }, allowLazyAllocation{ allowLazyAllocation } {}
+
+    LardAttachmentPool::~LardAttachmentPool() {
+        clear();
+    }
+
+    LardAttachmentPool::Handle LardAttachmentPool::request(const LardAttachmentDesc& desc, uint32_t firstUse, uint32_t lastUse) {
+        assert(!built && "Cannot request attachments from a pool that has been built, clear it first");
+        assert(firstUse <= lastUse && "Attachment lifetime ends before it starts");
+
+        Attachment attachment{};
+        attachment.desc = desc;
+        attachment.firstUse = firstUse;
+        attachment.lastUse = lastUse;
+        attachments.push_back(attachment);
+        return static_cast<Handle>(attachments.size() - 1);
+    }
+
+    bool LardAttachmentPool::canAlias(const MemoryRange& range, const Attachment& attachment) const {
+        if (range.lazy != attachment.lazy ||
+            (range.requirements.memoryTypeBits & attachment.requirements.memoryTypeBits) == 0) {
+            return false;
+        }
+        for (uint32_t other : range.attachments) {
+            const auto& otherAttachment = attachments[other];
+            if (attachment.firstUse <= otherAttachment.lastUse && otherAttachment.firstUse <= attachment.lastUse) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void LardAttachmentPool::build() {
+        assert(!built && "Attachment pool is already built");
+        auto& allocator = lardDevice.allocator();
+
+        for (auto& attachment : attachments) {
+            const auto& desc = attachment.desc;
+            bool transient = isTransientUsage(desc.usage);
+
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = desc.extent.width;
+            imageInfo.extent.height = desc.extent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = desc.format;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = desc.usage | (transient ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT : 0);
+            imageInfo.samples = desc.samples;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            if (vkCreateImage(lardDevice.device(), &imageInfo, nullptr, &attachment.image) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create attachment image!");
+            }
+            vkGetImageMemoryRequirements(lardDevice.device(), attachment.image, &attachment.requirements);
+            attachment.lazy = transient && allowLazyAllocation &&
+                allocator.hasMemoryType(
+                    attachment.requirements.memoryTypeBits,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+        }
+
+        // largest first, each attachment goes into the first range it fits in lifetime-wise,
+        // a range is as large as the largest attachment placed in it
+        std::vector<uint32_t> order(attachments.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return attachments[a].requirements.size > attachments[b].requirements.size;
+        });
+
+        for (uint32_t index : order) {
+            auto& attachment = attachments[index];
+            auto range = std::find_if(memoryRanges.begin(), memoryRanges.end(),
+                [&](const MemoryRange& r) { return canAlias(r, attachment); });
+            if (range == memoryRanges.end()) {
+                MemoryRange newRange{};
+                newRange.requirements = attachment.requirements;
+                newRange.lazy = attachment.lazy;
+                memoryRanges.push_back(newRange);
+                range = memoryRanges.end() - 1;
+            } else {
+                range->requirements.size = std::max(range->requirements.size, attachment.requirements.size);
+                range->requirements.alignment = std::max(range->requirements.alignment, attachment.requirements.alignment);
+                range->requirements.memoryTypeBits &= attachment.requirements.memoryTypeBits;
+            }
+            range->attachments.push_back(index);
+            attachment.memoryRange = static_cast<uint32_t>(range - memoryRanges.begin());
+        }
+
+        stats = Stats{};
+        stats.attachmentCount = static_cast<uint32_t>(attachments.size());
+        stats.memoryRangeCount = static_cast<uint32_t>(memoryRanges.size());
+        for (auto& range : memoryRanges) {
+            VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+            if (range.lazy) {
+                properties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+            }
+            range.allocation = allocator.allocate(range.requirements, properties, false);
+
+            stats.boundBytes += range.requirements.size;
+            if (range.lazy) {
+                stats.lazyBytes += range.requirements.size;
+            }
+        }
+
+        for (auto& attachment : attachments) {
+            const auto& allocation = memoryRanges[attachment.memoryRange].allocation;
+            if (vkBindImageMemory(lardDevice.device(), attachment.image, allocation.memory, allocation.offset) != VK_SUCCESS) {
+                throw std::runtime_error("failed to bind attachment memory!");
+            }
+            stats.requestedBytes += attachment.requirements.size;
+
+            VkImageViewCreateInfo viewInfo{};
+            viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            viewInfo.image = attachment.image;
+            viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+            viewInfo.format = attachment.desc.format;
+            viewInfo.subresourceRange.aspectMask = attachment.desc.aspect;
+            viewInfo.subresourceRange.baseMipLevel = 0;
+            viewInfo.subresourceRange.levelCount = 1;
+            viewInfo.subresourceRange.baseArrayLayer = 0;
+            viewInfo.subresourceRange.layerCount = 1;
+
+            if (vkCreateImageView(lardDevice.device(), &viewInfo, nullptr, &attachment.view) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create attachment image view!");
+            }
+        }
+        built = true;
+    }
+
+    void LardAttachmentPool::clear() {
+        for (auto& attachment : attachments) {
+            if (attachment.view != VK_NULL_HANDLE) {
+                vkDestroyImageView(lardDevice.device(), attachment.view, nullptr);
+            }
+            if (attachment.image != VK_NULL_HANDLE) {
+                vkDestroyImage(lardDevice.device(), attachment.image, nullptr);
+            }
+        }
+        for (auto& range : memoryRanges) {
+            if (range.allocation.memory != VK_NULL_HANDLE) {
+                lardDevice.allocator().free(range.allocation);
+            }
+        }
+        attachments.clear();
+        memoryRanges.clear();
+        stats = Stats{};
+        built = false;
+    }
+
+    void LardAttachmentPool::printStats(std::ostream& out) const {
+        constexpr double MiB = 1024.0 * 1024.0;
+
+        out << "attachments: " << stats.attachmentCount << " in " << stats.memoryRangeCount << " memory ranges, "
+            << stats.requestedBytes / MiB << " MiB requested, "
+            << stats.boundBytes / MiB << " MiB bound ("
+            << stats.lazyBytes / MiB << " MiB lazily allocated), "
+            << stats.aliasedBytes() / MiB << " MiB saved by aliasing" << std::endl;
+    }
+
+}  // namespace lard
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "lard_device.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace lard {
+
+    struct LardAttachmentDesc {
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+        VkImageUsageFlags usage = 0;
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    };
+
+    // Hands out render target images by format and extent. Attachments are requested with the
+    // range of passes they are used in, build() then places attachments whose ranges do not
+    // overlap in the same memory. Attachments only ever used as attachments (contents neither
+    // sampled nor copied) are created TRANSIENT and go to LAZILY_ALLOCATED memory when the
+    // device has it, tile based GPUs then never back them at all.
+    //
+    // Aliased attachments share memory, their contents are undefined at first use in a frame and
+    // must be transitioned from VK_IMAGE_LAYOUT_UNDEFINED.
+    class LardAttachmentPool {
+    public:
+        using Handle = uint32_t;
+        static constexpr uint32_t WHOLE_FRAME = UINT32_MAX;
+
+        struct Stats {
+            uint32_t attachmentCount = 0;
+            uint32_t memoryRangeCount = 0;
+            VkDeviceSize requestedBytes = 0;  // one memory range per attachment
+            VkDeviceSize boundBytes = 0;      // after aliasing
+            VkDeviceSize lazyBytes = 0;       // part of boundBytes in lazily allocated memory
+
+            VkDeviceSize aliasedBytes() const { return requestedBytes - boundBytes; }
+        };
+
+        explicit LardAttachmentPool(LardDevice& device, bool allowLazyAllocation = true);
+        ~LardAttachmentPool();
+        LardAttachmentPool(const LardAttachmentPool&) = delete;
+        LardAttachmentPool& operator=(const LardAttachmentPool&) = delete;
+
+        // firstUse and lastUse are pass indices within a frame, inclusive
+        Handle request(const LardAttachmentDesc& desc, uint32_t firstUse = 0, uint32_t lastUse = WHOLE_FRAME);
+        // creates the images and memory for everything requested since the last clear()
+        void build();
+        // the GPU must be done with every attachment
+        void clear();
+
+        VkImage getImage(Handle handle) const { return attachments[handle].image; }
+        VkImageView getView(Handle handle) const { return attachments[handle].view; }
+        const LardAttachmentDesc& getDesc(Handle handle) const { return attachments[handle].desc; }
+        bool isLazilyAllocated(Handle handle) const { return attachments[handle].lazy; }
+        // attachments in the same memory range alias each other
+        uint32_t getMemoryRange(Handle handle) const { return attachments[handle].memoryRange; }
+        size_t memoryRangeCount() const { return memoryRanges.size(); }
+        size_t size() const { return attachments.size(); }
+
+        const Stats& getStats() const { return stats; }
+        void printStats(std::ostream& out) const;
+
+    private:
+        struct Attachment {
+            LardAttachmentDesc desc;
+            uint32_t firstUse;
+            uint32_t lastUse;
+            VkImage image = VK_NULL_HANDLE;
+            VkImageView view = VK_NULL_HANDLE;
+            VkMemoryRequirements requirements{};
+            bool lazy = false;
+            uint32_t memoryRange = 0;
+        };
+
+        struct MemoryRange {
+            VkMemoryRequirements requirements{};
+            bool lazy = false;
+            std::vector<uint32_t> attachments;
+            LardAllocation allocation;
+        };
+
+        bool canAlias(const MemoryRange& range, const Attachment& attachment) const;
+
+        LardDevice& lardDevice;
+        bool allowLazyAllocation;
+        bool built = false;
+        std::vector<Attachment> attachments;
+        std::vector<MemoryRange> memoryRanges;
+        Stats stats;
+    };
+
+}  // namespace lard
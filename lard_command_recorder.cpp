@@ -0,0 +1,144 @@
+#include "lard_command_recorder.hpp"
+
+// std headers
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lard {
+
+    LardCommandRecorder::LardCommandRecorder(LardDevice& device, uint32_t frameCount, uint32_t threadCount)
+        : lardDevice{ device }, threadPool{ threadCount } {
+        QueueFamilyIndices queueFamilyIndices = lardDevice.findPhysicalQueueFamilies();
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+        // buffers are only ever recycled by resetting the whole pool
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        frames.resize(frameCount);
+        for (auto& frame : frames) {
+            frame.resize(threadPool.size());
+            for (auto& commands : frame) {
+                if (vkCreateCommandPool(lardDevice.device(), &poolInfo, nullptr, &commands.pool) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create command pool!");
+                }
+            }
+        }
+    }
+
+    LardCommandRecorder::~LardCommandRecorder() {
+        for (auto& frame : frames) {
+            for (auto& commands : frame) {
+                vkDestroyCommandPool(lardDevice.device(), commands.pool, nullptr);
+            }
+        }
+    }
+
+    void LardCommandRecorder::beginFrame(uint32_t frameIndex) {
+        assert(frameIndex < frames.size() && "Frame index out of range");
+        currentFrame = frameIndex;
+        for (auto& commands : frames[frameIndex]) {
+            if (commands.used > 0) {
+                vkResetCommandPool(lardDevice.device(), commands.pool, 0);
+                commands.used = 0;
+            }
+        }
+    }
+
+    VkCommandBuffer LardCommandRecorder::acquire(ThreadCommands& commands) {
+        if (commands.used == commands.buffers.size()) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = commands.pool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers(lardDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate secondary command buffer!");
+            }
+            commands.buffers.push_back(commandBuffer);
+        }
+        return commands.buffers[commands.used++];
+    }
+
+    void LardCommandRecorder::beginSecondary(
+        VkCommandBuffer commandBuffer,
+        const LardSecondaryInheritance& inheritance,
+        VkCommandBufferUsageFlags flags) {
+        VkCommandBufferInheritanceRenderingInfoKHR renderingInheritance{};
+        renderingInheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+        renderingInheritance.colorAttachmentCount = inheritance.colorFormat != VK_FORMAT_UNDEFINED ? 1 : 0;
+        renderingInheritance.pColorAttachmentFormats = &inheritance.colorFormat;
+        renderingInheritance.depthAttachmentFormat = inheritance.depthFormat;
+        renderingInheritance.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        if (inheritance.renderPass != VK_NULL_HANDLE) {
+            inheritanceInfo.renderPass = inheritance.renderPass;
+            inheritanceInfo.subpass = 0;
+            inheritanceInfo.framebuffer = inheritance.framebuffer;
+        } else {
+            inheritanceInfo.pNext = &renderingInheritance;
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = flags | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording secondary command buffer!");
+        }
+
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(inheritance.extent.width);
+        viewport.height = static_cast<float>(inheritance.extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        VkRect2D scissor{ {0, 0}, inheritance.extent };
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    }
+
+    void LardCommandRecorder::recordParallel(
+        VkCommandBuffer primary,
+        const LardSecondaryInheritance& inheritance,
+        size_t count,
+        const RecordFn& record,
+        size_t minChunkSize) {
+        if (count == 0) {
+            return;
+        }
+
+        // a couple of chunks per thread evens out chunks that take longer than others
+        size_t minChunk = std::max<size_t>(minChunkSize, 1);
+        size_t maxChunks = static_cast<size_t>(threadPool.size()) * 2;
+        size_t chunkCount = std::min(maxChunks, (count + minChunk - 1) / minChunk);
+        size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+        chunkCount = (count + chunkSize - 1) / chunkSize;
+
+        chunkBuffers.assign(chunkCount, VK_NULL_HANDLE);
+        auto& threadCommands = frames[currentFrame];
+        threadPool.parallelFor(static_cast<uint32_t>(chunkCount), [&](uint32_t chunk, uint32_t thread) {
+            // the worker owns threadCommands[thread] for the duration of the job, no locking needed
+            VkCommandBuffer commandBuffer = acquire(threadCommands[thread]);
+            beginSecondary(commandBuffer, inheritance);
+
+            size_t first = chunk * chunkSize;
+            record(commandBuffer, first, std::min(first + chunkSize, count));
+
+            if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to record secondary command buffer!");
+            }
+            chunkBuffers[chunk] = commandBuffer;
+        });
+
+        vkCmdExecuteCommands(primary, static_cast<uint32_t>(chunkBuffers.size()), chunkBuffers.data());
+    }
+
+}  // namespace lard
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "lard_device.hpp"
+#include "lard_thread_pool.hpp"
+
+// std lib headers
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace lard {
+
+    // What secondary command buffers recorded for a render pass instance inherit from it: the
+    // render pass and framebuffer, or under dynamic rendering the attachment formats. Viewport
+    // and scissor are not inherited, they are set to extent in every secondary buffer.
+    struct LardSecondaryInheritance {
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+        VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+    };
+
+    // Records a render pass's draws in parallel. Every worker thread has its own command pool per
+    // frame in flight, so recording never locks, and all pools of a frame slot are reset at once
+    // when the slot comes around again instead of freeing buffers one by one.
+    class LardCommandRecorder {
+    public:
+        // record(commandBuffer, begin, end) records items [begin, end) into a secondary buffer
+        using RecordFn = std::function<void(VkCommandBuffer, size_t, size_t)>;
+
+        static constexpr size_t DEFAULT_MIN_CHUNK_SIZE = 64;
+
+        // threadCount 0 uses one thread per hardware thread
+        LardCommandRecorder(LardDevice& device, uint32_t frameCount, uint32_t threadCount = 0);
+        ~LardCommandRecorder();
+        LardCommandRecorder(const LardCommandRecorder&) = delete;
+        LardCommandRecorder& operator=(const LardCommandRecorder&) = delete;
+
+        uint32_t threadCount() const { return threadPool.size(); }
+        LardThreadPool& getThreadPool() { return threadPool; }
+
+        // the GPU must be done with frameIndex, its secondary buffers are recycled
+        void beginFrame(uint32_t frameIndex);
+
+        // begins a secondary buffer continuing the render pass instance described by inheritance
+        // and sets viewport and scissor to its extent
+        static void beginSecondary(
+            VkCommandBuffer commandBuffer,
+            const LardSecondaryInheritance& inheritance,
+            VkCommandBufferUsageFlags flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+        // Splits [0, count) into chunks of at least minChunkSize, records them into secondary
+        // buffers on the worker threads and executes those in order, so draw order is kept.
+        // The render pass instance on primary must have been begun with secondary contents.
+        void recordParallel(
+            VkCommandBuffer primary,
+            const LardSecondaryInheritance& inheritance,
+            size_t count,
+            const RecordFn& record,
+            size_t minChunkSize = DEFAULT_MIN_CHUNK_SIZE);
+
+    private:
+        struct ThreadCommands {
+            VkCommandPool pool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> buffers;
+            size_t used = 0;
+        };
+
+        VkCommandBuffer acquire(ThreadCommands& commands);
+
+        LardDevice& lardDevice;
+        LardThreadPool threadPool;
+        // frames[frame][thread]
+        std::vector<std::vector<ThreadCommands>> frames;
+        uint32_t currentFrame = 0;
+        std::vector<VkCommandBuffer> chunkBuffers;
+    };
+
+}  // namespace lard
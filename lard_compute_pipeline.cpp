@@ -0,0 +1,56 @@
+#include "lard_compute_pipeline.hpp"
+#include "lard_shader_registry.hpp"
+
+// std headers
+#include <stdexcept>
+
+namespace lard {
+
+    LardComputePipeline::LardComputePipeline(
+        LardDevice& device,
+        const std::string& compShader,
+        VkPipelineLayout pipelineLayout,
+        const LardSpecialization& specialization)
+        : lardDevice{ device } {
+        auto code = LardShaderRegistry::get(compShader);
+
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = code.size;
+        moduleInfo.pCode = code.code;
+        VkShaderModule shaderModule;
+        if (vkCreateShaderModule(lardDevice.device(), &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create shader module");
+        }
+
+        VkSpecializationInfo specializationInfo = specialization.getInfo();
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = shaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.stage.pSpecializationInfo = specialization.empty() ? nullptr : &specializationInfo;
+        pipelineInfo.layout = pipelineLayout;
+
+        VkResult result = vkCreateComputePipelines(
+            lardDevice.device(), lardDevice.pipelineCache(), 1, &pipelineInfo, nullptr, &computePipeline);
+        // the module is not needed once the pipeline exists
+        vkDestroyShaderModule(lardDevice.device(), shaderModule, nullptr);
+        if (result != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create compute pipeline " + compShader);
+        }
+    }
+
+    LardComputePipeline::~LardComputePipeline() {
+        VkDevice device = lardDevice.device();
+        VkPipeline pipeline = computePipeline;
+        lardDevice.deferDestroy([device, pipeline]() { vkDestroyPipeline(device, pipeline, nullptr); });
+    }
+
+    void LardComputePipeline::bind(VkCommandBuffer commandBuffer) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+    }
+
+}  // namespace lard
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "lard_device.hpp"
+#include "lard_pipeline.hpp"
+
+// std lib headers
+#include <string>
+
+namespace lard {
+
+    // A compute pipeline, built synchronously through the device's pipeline cache. Compute
+    // pipelines have a single small stage, unlike graphics pipelines they are cheap enough to
+    // create where they are first needed.
+    class LardComputePipeline {
+    public:
+        // compShader is a LardShaderRegistry name, e.g. "cull_objects.comp"
+        LardComputePipeline(
+            LardDevice& device,
+            const std::string& compShader,
+            VkPipelineLayout pipelineLayout,
+            const LardSpecialization& specialization = {});
+        // the pipeline is destroyed once the frames that may still use it have retired
+        ~LardComputePipeline();
+        LardComputePipeline(const LardComputePipeline&) = delete;
+        LardComputePipeline& operator=(const LardComputePipeline&) = delete;
+
+        void bind(VkCommandBuffer commandBuffer);
+
+    private:
+        LardDevice& lardDevice;
+        VkPipeline computePipeline;
+    };
+
+}  // namespace lard
@@ -1,7 +1,11 @@
 #include "lard_device.hpp"
+#include "lard_uploader.hpp"
 
 // std headers
+#include <algorithm>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -47,16 +51,34 @@ void DestroyDebugUtilsMessengerEXT(
 }
 
 // class member functions
-LardDevice::LardDevice(LardWindow &window) : window{window} {
+LardDevice::LardDevice(LardWindow *window, bool allowDynamicRendering)
+    : window{window}, dynamicRendering_{allowDynamicRendering} {
+  if (isHeadless()) {
+    deviceExtensions.clear();
+  }
   createInstance();
   setupDebugMessenger();
   createSurface();
   pickPhysicalDevice();
   createLogicalDevice();
   createCommandPool();
+  createFrameTimeline();
+  createPipelineCache();
+  allocator_ = std::make_unique<LardAllocator>(device_, physicalDevice);
+  uploader_ = std::make_unique<LardUploader>(*this);
 }
 
 LardDevice::~LardDevice() {
+  vkDeviceWaitIdle(device_);
+  for (auto &deletion : pendingDeletions_) {
+    deletion.destroy();
+  }
+  pendingDeletions_.clear();
+  savePipelineCache();
+  vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
+  uploader_.reset();
+  allocator_.reset();
+  vkDestroySemaphore(device_, frameTimeline_, nullptr);
   vkDestroyCommandPool(device_, commandPool, nullptr);
   vkDestroyDevice(device_, nullptr);
 
@@ -64,7 +86,9 @@ LardDevice::~LardDevice() {
     DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
   }
 
-  vkDestroySurfaceKHR(instance, surface_, nullptr);
+  if (!isHeadless()) {
+    vkDestroySurfaceKHR(instance, surface_, nullptr);
+  }
   vkDestroyInstance(instance, nullptr);
 }
 
@@ -79,7 +103,7 @@ void LardDevice::createInstance() {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "No Engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  appInfo.apiVersion = VK_API_VERSION_1_2;
 
   VkInstanceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -137,7 +161,10 @@ void LardDevice::createLogicalDevice() {
   QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+  std::set<uint32_t> uniqueQueueFamilies = {
+      indices.graphicsFamily,
+      indices.presentFamily,
+      indices.transferFamily};
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -152,15 +179,52 @@ void LardDevice::createLogicalDevice() {
   VkPhysicalDeviceFeatures deviceFeatures = {};
   deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+  VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+  vulkan12Features.timelineSemaphore = VK_TRUE;
+
+  // optional, for GPU driven rendering; core in 1.2 so no extension to enable
+  indirectCount_ = checkIndirectCountSupport(physicalDevice);
+  if (indirectCount_) {
+    vulkan12Features.drawIndirectCount = VK_TRUE;
+    deviceFeatures.multiDrawIndirect = VK_TRUE;
+    deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+  }
+
+  // optional, the renderer falls back to a render pass and framebuffers without it
+  VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {};
+  dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+  std::vector<const char *> enabledExtensions = deviceExtensions;
+  void **featuresTail = &vulkan12Features.pNext;
+  dynamicRendering_ = dynamicRendering_ && checkDynamicRenderingSupport(physicalDevice);
+  if (dynamicRendering_) {
+    dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+    *featuresTail = &dynamicRenderingFeatures;
+    featuresTail = &dynamicRenderingFeatures.pNext;
+    enabledExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+  }
+
+  // optional as well, the render graph's barriers are translated to legacy ones without it
+  VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = {};
+  synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+  synchronization2_ = checkSynchronization2Support(physicalDevice);
+  if (synchronization2_) {
+    synchronization2Features.synchronization2 = VK_TRUE;
+    *featuresTail = &synchronization2Features;
+    featuresTail = &synchronization2Features.pNext;
+    enabledExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+  }
+
   VkDeviceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+  createInfo.pNext = &vulkan12Features;
 
   createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+  createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -177,6 +241,18 @@ void LardDevice::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+  vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+
+  if (dynamicRendering_) {
+    cmdBeginRendering_ = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdBeginRenderingKHR"));
+    cmdEndRendering_ = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdEndRenderingKHR"));
+  }
+  if (synchronization2_) {
+    cmdPipelineBarrier2_ = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(
+        vkGetDeviceProcAddr(device_, "vkCmdPipelineBarrier2KHR"));
+  }
 }
 
 void LardDevice::createCommandPool() {
@@ -193,24 +269,55 @@ void LardDevice::createCommandPool() {
   }
 }
 
-void LardDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+void LardDevice::createFrameTimeline() {
+  VkSemaphoreTypeCreateInfo typeInfo = {};
+  typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+  typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  typeInfo.initialValue = 0;
+
+  VkSemaphoreCreateInfo semaphoreInfo = {};
+  semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+  semaphoreInfo.pNext = &typeInfo;
+
+  if (vkCreateSemaphore(device_, &semaphoreInfo, nullptr, &frameTimeline_) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create frame timeline semaphore!");
+  }
+}
+
+void LardDevice::createSurface() {
+  if (isHeadless()) {
+    surface_ = VK_NULL_HANDLE;
+    return;
+  }
+  window->createWindowSurface(instance, &surface_);
+}
 
 bool LardDevice::isDeviceSuitable(VkPhysicalDevice device) {
   QueueFamilyIndices indices = findQueueFamilies(device);
 
   bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported) {
+  bool swapChainAdequate = isHeadless();
+  if (extensionsSupported && !isHeadless()) {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
   }
 
-  VkPhysicalDeviceFeatures supportedFeatures;
-  vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
+  VkPhysicalDeviceProperties deviceProperties;
+  vkGetPhysicalDeviceProperties(device, &deviceProperties);
+  if (deviceProperties.apiVersion < VK_API_VERSION_1_2) {
+    return false;
+  }
+
+  VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+  VkPhysicalDeviceFeatures2 supportedFeatures = {};
+  supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  supportedFeatures.pNext = &vulkan12Features;
+  vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
 
   return indices.isComplete() && extensionsSupported && swapChainAdequate &&
-         supportedFeatures.samplerAnisotropy;
+         supportedFeatures.features.samplerAnisotropy && vulkan12Features.timelineSemaphore;
 }
 
 void LardDevice::populateDebugMessengerCreateInfo(
@@ -261,11 +368,13 @@ bool LardDevice::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> LardDevice::getRequiredExtensions() {
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  std::vector<const char *> extensions;
+  if (!isHeadless()) {
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions;
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -317,6 +426,59 @@ bool LardDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
   return requiredExtensions.empty();
 }
 
+static bool hasDeviceExtension(VkPhysicalDevice device, const char *name) {
+  uint32_t extensionCount;
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+  std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+  return std::any_of(
+      availableExtensions.begin(),
+      availableExtensions.end(),
+      [name](const VkExtensionProperties &extension) {
+        return strcmp(extension.extensionName, name) == 0;
+      });
+}
+
+bool LardDevice::checkDynamicRenderingSupport(VkPhysicalDevice device) {
+  if (!hasDeviceExtension(device, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+    return false;
+  }
+
+  VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {};
+  dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+  VkPhysicalDeviceFeatures2 supportedFeatures = {};
+  supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  supportedFeatures.pNext = &dynamicRenderingFeatures;
+  vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
+  return dynamicRenderingFeatures.dynamicRendering;
+}
+
+bool LardDevice::checkSynchronization2Support(VkPhysicalDevice device) {
+  if (!hasDeviceExtension(device, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+    return false;
+  }
+
+  VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = {};
+  synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+  VkPhysicalDeviceFeatures2 supportedFeatures = {};
+  supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  supportedFeatures.pNext = &synchronization2Features;
+  vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
+  return synchronization2Features.synchronization2;
+}
+
+bool LardDevice::checkIndirectCountSupport(VkPhysicalDevice device) {
+  VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+  vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_12_FEATURES;
+  VkPhysicalDeviceFeatures2 supportedFeatures = {};
+  supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+  supportedFeatures.pNext = &vulkan12Features;
+  vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
+  return vulkan12Features.drawIndirectCount && supportedFeatures.features.multiDrawIndirect &&
+         supportedFeatures.features.drawIndirectFirstInstance;
+}
+
 QueueFamilyIndices LardDevice::findQueueFamilies(VkPhysicalDevice device) {
   QueueFamilyIndices indices;
 
@@ -326,25 +488,40 @@ QueueFamilyIndices LardDevice::findQueueFamilies(VkPhysicalDevice device) {
   std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
   vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
-  int i = 0;
+  uint32_t i = 0;
   for (const auto &queueFamily : queueFamilies) {
-    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-      indices.graphicsFamily = i;
-      indices.graphicsFamilyHasValue = true;
-    }
-    VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-    if (queueFamily.queueCount > 0 && presentSupport) {
-      indices.presentFamily = i;
-      indices.presentFamilyHasValue = true;
+    if (!indices.isComplete()) {
+      if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        indices.graphicsFamily = i;
+        indices.graphicsFamilyHasValue = true;
+      }
+      // headless frames are never presented, the graphics queue stands in for present
+      VkBool32 presentSupport = false;
+      if (isHeadless()) {
+        presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == i;
+      } else {
+        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+      }
+      if (queueFamily.queueCount > 0 && presentSupport) {
+        indices.presentFamily = i;
+        indices.presentFamilyHasValue = true;
+      }
     }
-    if (indices.isComplete()) {
-      break;
+    // a transfer only family is usually backed by the copy engines of discrete GPUs
+    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT &&
+        !(queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) &&
+        !indices.transferFamilyHasValue) {
+      indices.transferFamily = i;
+      indices.transferFamilyHasValue = true;
     }
 
     i++;
   }
 
+  if (!indices.transferFamilyHasValue) {
+    indices.transferFamily = indices.graphicsFamily;
+  }
+
   return indices;
 }
 
@@ -391,16 +568,7 @@ VkFormat LardDevice::findSupportedFormat(
 }
 
 uint32_t LardDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-  VkPhysicalDeviceMemoryProperties memProperties;
-  vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-    if ((typeFilter & (1 << i)) &&
-        (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-      return i;
-    }
-  }
-
-  throw std::runtime_error("failed to find suitable memory type!");
+  return allocator_->findMemoryType(typeFilter, properties);
 }
 
 void LardDevice::createBuffer(
@@ -408,7 +576,7 @@ void LardDevice::createBuffer(
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    LardAllocation &bufferAllocation) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
@@ -422,16 +590,19 @@ void LardDevice::createBuffer(
   VkMemoryRequirements memRequirements;
   vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+  bufferAllocation = allocator_->allocate(memRequirements, properties, true);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate vertex buffer memory!");
+  if (vkBindBufferMemory(device_, buffer, bufferAllocation.memory, bufferAllocation.offset) !=
+      VK_SUCCESS) {
+    destroyBuffer(buffer, bufferAllocation);
+    buffer = VK_NULL_HANDLE;
+    throw std::runtime_error("failed to bind buffer memory!");
   }
+}
 
-  vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+void LardDevice::destroyBuffer(VkBuffer buffer, LardAllocation &bufferAllocation) {
+  vkDestroyBuffer(device_, buffer, nullptr);
+  allocator_->free(bufferAllocation);
 }
 
 VkCommandBuffer LardDevice::beginSingleTimeCommands() {
@@ -460,56 +631,275 @@ void LardDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
-  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(graphicsQueue_);
+  // wait for this submission only, not for every frame already queued behind it
+  VkFenceCreateInfo fenceInfo{};
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  VkFence fence;
+  if (vkCreateFence(device_, &fenceInfo, nullptr, &fence) != VK_SUCCESS) {
+    throw std::runtime_error("failed to create single time command fence!");
+  }
+
+  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence);
+  vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
 
+  vkDestroyFence(device_, fence, nullptr);
   vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
 }
 
-void LardDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+static uint32_t readLittleEndian32(const char *bytes) {
+  auto b = reinterpret_cast<const unsigned char *>(bytes);
+  return uint32_t(b[0]) | uint32_t(b[1]) << 8 | uint32_t(b[2]) << 16 | uint32_t(b[3]) << 24;
+}
+
+std::vector<char> LardDevice::readPipelineCacheFile() {
+  std::ifstream file{PIPELINE_CACHE_PATH, std::ios::ate | std::ios::binary};
+  if (!file.is_open()) {
+    pipelineCacheStatus_ = std::string{"cold (no "} + PIPELINE_CACHE_PATH + ")";
+    return {};
+  }
+  std::vector<char> data(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(data.data(), data.size());
+  if (!file) {
+    pipelineCacheStatus_ = std::string{"cold (failed to read "} + PIPELINE_CACHE_PATH + ")";
+    return {};
+  }
+
+  // VkPipelineCacheHeaderVersionOne, always stored least significant byte first
+  constexpr size_t headerSize = 16 + VK_UUID_SIZE;
+  if (data.size() < headerSize || readLittleEndian32(&data[0]) < headerSize ||
+      readLittleEndian32(&data[0]) > data.size() ||
+      readLittleEndian32(&data[4]) != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) {
+    pipelineCacheStatus_ = "cold (bad header)";
+    return {};
+  }
+  if (readLittleEndian32(&data[8]) != properties.vendorID ||
+      readLittleEndian32(&data[12]) != properties.deviceID ||
+      std::memcmp(&data[16], properties.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+    pipelineCacheStatus_ = "cold (written by another device or driver)";
+    return {};
+  }
+  return data;
+}
+
+void LardDevice::createPipelineCache() {
+  std::vector<char> data = readPipelineCacheFile();
+
+  VkPipelineCacheCreateInfo cacheInfo{};
+  cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cacheInfo.initialDataSize = data.size();
+  cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+  if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS) {
+    // the driver rejected the data after all, start over empty
+    cacheInfo.initialDataSize = 0;
+    cacheInfo.pInitialData = nullptr;
+    data.clear();
+    if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS) {
+      throw std::runtime_error("failed to create pipeline cache!");
+    }
+  }
+
+  pipelineCacheWarm_ = !data.empty();
+  if (pipelineCacheWarm_) {
+    pipelineCacheStatus_ = "warm (" + std::to_string(data.size()) + " bytes)";
+  } else if (pipelineCacheStatus_.empty()) {
+    pipelineCacheStatus_ = "cold (rejected by the driver)";
+  }
+}
+
+void LardDevice::printFeatures(std::ostream &out) {
+  out << "dynamic rendering: " << (dynamicRendering_ ? "on" : "off") << std::endl;
+  out << "synchronization2: " << (synchronization2_ ? "on" : "off") << std::endl;
+  out << "indirect count: " << (indirectCount_ ? "on" : "off") << std::endl;
+  out << "pipeline cache: " << pipelineCacheStatus_ << std::endl;
+}
+
+void LardDevice::savePipelineCache() {
+  size_t size = 0;
+  if (vkGetPipelineCacheData(device_, pipelineCache_, &size, nullptr) != VK_SUCCESS || size == 0) {
+    return;
+  }
+  std::vector<char> data(size);
+  if (vkGetPipelineCacheData(device_, pipelineCache_, &size, data.data()) != VK_SUCCESS) {
+    return;
+  }
+
+  // a reader sees either the old file or the complete new one
+  std::string tempPath = std::string{PIPELINE_CACHE_PATH} + ".tmp";
+  {
+    std::ofstream file{tempPath, std::ios::binary | std::ios::trunc};
+    file.write(data.data(), size);
+    file.flush();
+    if (!file) {
+      std::cerr << "failed to write " << tempPath << std::endl;
+      std::remove(tempPath.c_str());
+      return;
+    }
+  }
+  if (std::rename(tempPath.c_str(), PIPELINE_CACHE_PATH) != 0) {
+    std::cerr << "failed to replace " << PIPELINE_CACHE_PATH << std::endl;
+    std::remove(tempPath.c_str());
+  }
+}
 
-  VkBufferCopy copyRegion{};
-  copyRegion.srcOffset = 0;  // Optional
-  copyRegion.dstOffset = 0;  // Optional
-  copyRegion.size = size;
-  vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
+void LardDevice::deferDestroy(std::function<void()> destroy, LardUploadToken token) {
+  pendingDeletions_.push_back({currentFrame_, token, std::move(destroy)});
+}
+
+void LardDevice::deferDestroyBuffer(
+    VkBuffer buffer, LardAllocation &bufferAllocation, LardUploadToken token) {
+  deferDestroy(
+      [this, buffer, allocation = bufferAllocation]() mutable { destroyBuffer(buffer, allocation); },
+      token);
+  bufferAllocation = LardAllocation{};
+}
 
-  endSingleTimeCommands(commandBuffer);
+void LardDevice::deferDestroyImage(VkImage image, LardAllocation &imageAllocation, LardUploadToken token) {
+  deferDestroy(
+      [this, image, allocation = imageAllocation]() mutable { destroyImage(image, allocation); },
+      token);
+  imageAllocation = LardAllocation{};
 }
 
-void LardDevice::copyBufferToImage(
+uint64_t LardDevice::completedFrame() {
+  vkGetSemaphoreCounterValue(device_, frameTimeline_, &completedFrame_);
+  return completedFrame_;
+}
+
+void LardDevice::waitForFrame(uint64_t frame) {
+  if (isFrameComplete(frame)) {
+    return;
+  }
+
+  VkSemaphoreWaitInfo waitInfo = {};
+  waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+  waitInfo.semaphoreCount = 1;
+  waitInfo.pSemaphores = &frameTimeline_;
+  waitInfo.pValues = &frame;
+  if (vkWaitSemaphores(device_, &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+    throw std::runtime_error("failed to wait for frame!");
+  }
+  completedFrame_ = std::max(completedFrame_, frame);
+}
+
+void LardDevice::beginFrame() {
+  currentFrame_++;
+  collectDeletions(completedFrame());
+}
+
+void LardDevice::collectDeletions(uint64_t completedFrame) {
+  // entries are in frame order, but one may still wait on its upload while later ones are free
+  for (auto it = pendingDeletions_.begin();
+       it != pendingDeletions_.end() && it->frame <= completedFrame;) {
+    if (uploader_->isComplete(it->token)) {
+      it->destroy();
+      it = pendingDeletions_.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+LardUploadToken LardDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+  return uploader_->copyBuffer(srcBuffer, dstBuffer, size);
+}
+
+LardUploadToken LardDevice::copyBufferToImage(
     VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount) {
-  VkCommandBuffer commandBuffer = beginSingleTimeCommands();
+  return uploader_->copyBufferToImage(buffer, image, width, height, layerCount);
+}
 
-  VkBufferImageCopy region{};
-  region.bufferOffset = 0;
-  region.bufferRowLength = 0;
-  region.bufferImageHeight = 0;
+// the legacy stage and access bits have the same values as their *2 counterparts, only the
+// bits above 32 need folding into the broader legacy ones
+static VkPipelineStageFlags toLegacyStages(VkPipelineStageFlags2KHR stages, VkPipelineStageFlags none) {
+  if (stages & (VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT)) {
+    stages |= VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT;
+  }
+  if (stages & VK_PIPELINE_STAGE_2_COPY_BIT) {
+    stages |= VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+  }
+  auto legacy = static_cast<VkPipelineStageFlags>(stages & 0xffffffffull);
+  return legacy != 0 ? legacy : none;
+}
 
-  region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  region.imageSubresource.mipLevel = 0;
-  region.imageSubresource.baseArrayLayer = 0;
-  region.imageSubresource.layerCount = layerCount;
+static VkAccessFlags toLegacyAccess(VkAccessFlags2KHR access) {
+  if (access & (VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT)) {
+    access |= VK_ACCESS_2_SHADER_READ_BIT;
+  }
+  if (access & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT) {
+    access |= VK_ACCESS_2_SHADER_WRITE_BIT;
+  }
+  return static_cast<VkAccessFlags>(access & 0xffffffffull);
+}
 
-  region.imageOffset = {0, 0, 0};
-  region.imageExtent = {width, height, 1};
+void LardDevice::cmdPipelineBarrier2(
+    VkCommandBuffer commandBuffer,
+    const VkDependencyInfoKHR *dependencyInfo) {
+  if (synchronization2_) {
+    cmdPipelineBarrier2_(commandBuffer, dependencyInfo);
+    return;
+  }
 
-  vkCmdCopyBufferToImage(
+  // a single legacy barrier call, stages of all barriers are merged
+  VkPipelineStageFlags2KHR srcStages = 0;
+  VkPipelineStageFlags2KHR dstStages = 0;
+  std::vector<VkMemoryBarrier> memoryBarriers(dependencyInfo->memoryBarrierCount);
+  for (uint32_t i = 0; i < dependencyInfo->memoryBarrierCount; i++) {
+    const auto &barrier = dependencyInfo->pMemoryBarriers[i];
+    srcStages |= barrier.srcStageMask;
+    dstStages |= barrier.dstStageMask;
+    memoryBarriers[i].sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    memoryBarriers[i].srcAccessMask = toLegacyAccess(barrier.srcAccessMask);
+    memoryBarriers[i].dstAccessMask = toLegacyAccess(barrier.dstAccessMask);
+  }
+  std::vector<VkBufferMemoryBarrier> bufferBarriers(dependencyInfo->bufferMemoryBarrierCount);
+  for (uint32_t i = 0; i < dependencyInfo->bufferMemoryBarrierCount; i++) {
+    const auto &barrier = dependencyInfo->pBufferMemoryBarriers[i];
+    srcStages |= barrier.srcStageMask;
+    dstStages |= barrier.dstStageMask;
+    bufferBarriers[i].sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferBarriers[i].srcAccessMask = toLegacyAccess(barrier.srcAccessMask);
+    bufferBarriers[i].dstAccessMask = toLegacyAccess(barrier.dstAccessMask);
+    bufferBarriers[i].srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+    bufferBarriers[i].dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+    bufferBarriers[i].buffer = barrier.buffer;
+    bufferBarriers[i].offset = barrier.offset;
+    bufferBarriers[i].size = barrier.size;
+  }
+  std::vector<VkImageMemoryBarrier> imageBarriers(dependencyInfo->imageMemoryBarrierCount);
+  for (uint32_t i = 0; i < dependencyInfo->imageMemoryBarrierCount; i++) {
+    const auto &barrier = dependencyInfo->pImageMemoryBarriers[i];
+    srcStages |= barrier.srcStageMask;
+    dstStages |= barrier.dstStageMask;
+    imageBarriers[i].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    imageBarriers[i].srcAccessMask = toLegacyAccess(barrier.srcAccessMask);
+    imageBarriers[i].dstAccessMask = toLegacyAccess(barrier.dstAccessMask);
+    imageBarriers[i].oldLayout = barrier.oldLayout;
+    imageBarriers[i].newLayout = barrier.newLayout;
+    imageBarriers[i].srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+    imageBarriers[i].dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+    imageBarriers[i].image = barrier.image;
+    imageBarriers[i].subresourceRange = barrier.subresourceRange;
+  }
+
+  vkCmdPipelineBarrier(
       commandBuffer,
-      buffer,
-      image,
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-      1,
-      &region);
-  endSingleTimeCommands(commandBuffer);
+      toLegacyStages(srcStages, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT),
+      toLegacyStages(dstStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT),
+      dependencyInfo->dependencyFlags,
+      static_cast<uint32_t>(memoryBarriers.size()),
+      memoryBarriers.data(),
+      static_cast<uint32_t>(bufferBarriers.size()),
+      bufferBarriers.data(),
+      static_cast<uint32_t>(imageBarriers.size()),
+      imageBarriers.data());
 }
 
 void LardDevice::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage &image,
-    VkDeviceMemory &imageMemory) {
+    LardAllocation &imageAllocation) {
   if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
     throw std::runtime_error("failed to create image!");
   }
@@ -517,18 +907,22 @@ void LardDevice::createImageWithInfo(
   VkMemoryRequirements memRequirements;
   vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate image memory!");
-  }
+  imageAllocation = allocator_->allocate(
+      memRequirements,
+      properties,
+      imageInfo.tiling == VK_IMAGE_TILING_LINEAR);
 
-  if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+  if (vkBindImageMemory(device_, image, imageAllocation.memory, imageAllocation.offset) !=
+      VK_SUCCESS) {
+    destroyImage(image, imageAllocation);
+    image = VK_NULL_HANDLE;
     throw std::runtime_error("failed to bind image memory!");
   }
 }
 
+void LardDevice::destroyImage(VkImage image, LardAllocation &imageAllocation) {
+  vkDestroyImage(device_, image, nullptr);
+  allocator_->free(imageAllocation);
+}
+
 }  // namespace lve
\ No newline at end of file
@@ -1,13 +1,24 @@
 #pragma once
 
+#include "lard_allocator.hpp"
 #include "lard_window.hpp"
 
 // std lib headers
+#include <deque>
+#include <functional>
+#include <memory>
+#include <ostream>
 #include <string>
 #include <vector>
 
 namespace lard {
 
+class LardUploader;
+
+struct LardUploadToken {
+  uint64_t value = 0;
+};
+
 struct SwapChainSupportDetails {
   VkSurfaceCapabilitiesKHR capabilities;
   std::vector<VkSurfaceFormatKHR> formats;
@@ -17,9 +28,12 @@ struct SwapChainSupportDetails {
 struct QueueFamilyIndices {
   uint32_t graphicsFamily;
   uint32_t presentFamily;
+  uint32_t transferFamily;  // dedicated transfer family if there is one, graphicsFamily otherwise
   bool graphicsFamilyHasValue = false;
   bool presentFamilyHasValue = false;
+  bool transferFamilyHasValue = false;
   bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
+  bool hasDedicatedTransfer() { return transferFamily != graphicsFamily; }
 };
 
 class LardDevice {
@@ -30,7 +44,9 @@ class LardDevice {
   const bool enableValidationLayers = true;
 #endif
 
-  LardDevice(LardWindow &window);
+  LardDevice(LardWindow &window) : LardDevice{&window} {}
+  // a null window creates a headless device: no surface, no VK_KHR_swapchain, no GLFW calls
+  explicit LardDevice(LardWindow *window, bool allowDynamicRendering = true);
   ~LardDevice();
 
   // Not copyable or movable
@@ -41,9 +57,37 @@ class LardDevice {
 
   VkCommandPool getCommandPool() { return commandPool; }
   VkDevice device() { return device_; }
+  VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
   VkSurfaceKHR surface() { return surface_; }
+  bool isHeadless() { return window == nullptr; }
+  // VK_KHR_dynamic_rendering, on when the device supports it unless it was turned off
+  bool hasDynamicRendering() { return dynamicRendering_; }
+  void cmdBeginRendering(VkCommandBuffer commandBuffer, const VkRenderingInfoKHR *renderingInfo) {
+    cmdBeginRendering_(commandBuffer, renderingInfo);
+  }
+  void cmdEndRendering(VkCommandBuffer commandBuffer) { cmdEndRendering_(commandBuffer); }
+  // VK_KHR_synchronization2, without it cmdPipelineBarrier2 issues the same barriers through
+  // vkCmdPipelineBarrier with the stage and access masks narrowed to their legacy equivalents
+  bool hasSynchronization2() { return synchronization2_; }
+  void cmdPipelineBarrier2(VkCommandBuffer commandBuffer, const VkDependencyInfoKHR *dependencyInfo);
+  // drawIndirectCount with multiDrawIndirect and drawIndirectFirstInstance, everything GPU
+  // driven rendering needs; render systems draw from the CPU without it
+  bool hasIndirectCount() { return indirectCount_; }
+  // Shared by every pipeline. Loaded from PIPELINE_CACHE_PATH when the file's header matches this
+  // device and driver, written back on destruction through a temporary file and a rename so an
+  // interrupted write never leaves a truncated cache behind.
+  static constexpr const char *PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+  VkPipelineCache pipelineCache() { return pipelineCache_; }
+  // true when pipelineCache() was seeded from disk
+  bool isPipelineCacheWarm() { return pipelineCacheWarm_; }
+  // the optional features in use and where the pipeline cache came from, for startup reports
+  void printFeatures(std::ostream &out);
+  void savePipelineCache();
   VkQueue graphicsQueue() { return graphicsQueue_; }
   VkQueue presentQueue() { return presentQueue_; }
+  VkQueue transferQueue() { return transferQueue_; }
+  LardAllocator &allocator() { return *allocator_; }
+  LardUploader &uploader() { return *uploader_; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -51,24 +95,45 @@ class LardDevice {
   VkFormat findSupportedFormat(
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
-  // Buffer Helper Functions
+  // Buffer Helper Functions, copies are queued on the uploader and complete asynchronously
   void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      LardAllocation &bufferAllocation);
+  void destroyBuffer(VkBuffer buffer, LardAllocation &bufferAllocation);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-  void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
-  void copyBufferToImage(
+  LardUploadToken copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+  LardUploadToken copyBufferToImage(
       VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
   void createImageWithInfo(
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      LardAllocation &imageAllocation);
+  void destroyImage(VkImage image, LardAllocation &imageAllocation);
+
+  // Deferred destruction: the handle is kept alive until the frame currently being recorded has
+  // retired on the GPU and the upload behind token, if any, has completed. Lets objects be
+  // dropped mid-game without vkDeviceWaitIdle.
+  void deferDestroy(std::function<void()> destroy, LardUploadToken token = {});
+  void deferDestroyBuffer(VkBuffer buffer, LardAllocation &bufferAllocation, LardUploadToken token = {});
+  void deferDestroyImage(VkImage image, LardAllocation &imageAllocation, LardUploadToken token = {});
+
+  // Frame pacing. Frames are numbered from 1 and every frame submitted on the graphics queue
+  // signals frameTimeline() with its number, so "has frame N completed" is a counter compare.
+  VkSemaphore frameTimeline() { return frameTimeline_; }
+  uint64_t currentFrame() { return currentFrame_; }
+  uint64_t completedFrame();
+  bool isFrameComplete(uint64_t frame) { return frame <= completedFrame_ || frame <= completedFrame(); }
+  void waitForFrame(uint64_t frame);
+  // called by the renderer once per frame before recording, also runs deferred deletions
+  void beginFrame();
+  // destroys everything queued for frames up to completedFrame whose uploads are done
+  void collectDeletions(uint64_t completedFrame);
 
   VkPhysicalDeviceProperties properties;
 
@@ -79,6 +144,8 @@ class LardDevice {
   void pickPhysicalDevice();
   void createLogicalDevice();
   void createCommandPool();
+  void createFrameTimeline();
+  void createPipelineCache();
 
   // helper functions
   bool isDeviceSuitable(VkPhysicalDevice device);
@@ -88,21 +155,48 @@ class LardDevice {
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+  bool checkDynamicRenderingSupport(VkPhysicalDevice device);
+  bool checkSynchronization2Support(VkPhysicalDevice device);
+  bool checkIndirectCountSupport(VkPhysicalDevice device);
+  // empty if the file is missing or was written by another device, driver or cache version
+  std::vector<char> readPipelineCacheFile();
   SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
   VkInstance instance;
   VkDebugUtilsMessengerEXT debugMessenger;
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-  LardWindow &window;
+  LardWindow *window;
   VkCommandPool commandPool;
 
   VkDevice device_;
   VkSurfaceKHR surface_;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  VkQueue transferQueue_;
+  bool dynamicRendering_;
+  PFN_vkCmdBeginRenderingKHR cmdBeginRendering_ = nullptr;
+  PFN_vkCmdEndRenderingKHR cmdEndRendering_ = nullptr;
+  bool synchronization2_ = false;
+  bool indirectCount_ = false;
+  PFN_vkCmdPipelineBarrier2KHR cmdPipelineBarrier2_ = nullptr;
+  VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+  bool pipelineCacheWarm_ = false;
+  std::string pipelineCacheStatus_;
+  std::unique_ptr<LardAllocator> allocator_;
+  std::unique_ptr<LardUploader> uploader_;
+
+  struct PendingDeletion {
+    uint64_t frame;
+    LardUploadToken token;
+    std::function<void()> destroy;
+  };
+  std::deque<PendingDeletion> pendingDeletions_;
+  VkSemaphore frameTimeline_;
+  uint64_t currentFrame_ = 0;
+  uint64_t completedFrame_ = 0;
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
-  const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+  std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
 };
 
 }  // namespace lard
\ No newline at end of file
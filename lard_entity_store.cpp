@@ -0,0 +1,131 @@
+#include "lard_entity_store.hpp"
+
+// std headers
+#include <atomic>
+#include <cassert>
+#include <stdexcept>
+
+namespace lard {
+
+    uint64_t LardEntityStore::nextVersion() {
+        // starts at 1, 0 is never a version
+        static std::atomic<uint64_t> counter{ 0 };
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    LardEntityStore::id_t LardEntityStore::add(LardGameObject&& object) {
+        id_t id = object.getId();
+        if (!indices.emplace(id, ids_.size()).second) {
+            throw std::runtime_error("entity already in the store");
+        }
+        ids_.push_back(id);
+        models_.push_back(acquireModel(std::move(object.model)));
+        translations_.push_back(object.transform2d.translation);
+        scales_.push_back(object.transform2d.scale);
+        rotations_.push_back(object.transform2d.rotation);
+        colors_.push_back(object.color);
+        animations_.push_back(object.animation);
+        version = nextVersion();
+        return id;
+    }
+
+    void LardEntityStore::remove(id_t id) {
+        size_t index = indexOf(id);
+        size_t last = ids_.size() - 1;
+        releaseModel(models_[index]);
+        if (index != last) {
+            ids_[index] = ids_[last];
+            models_[index] = models_[last];
+            translations_[index] = translations_[last];
+            scales_[index] = scales_[last];
+            rotations_[index] = rotations_[last];
+            colors_[index] = colors_[last];
+            animations_[index] = animations_[last];
+            indices[ids_[index]] = index;
+        }
+        ids_.pop_back();
+        models_.pop_back();
+        translations_.pop_back();
+        scales_.pop_back();
+        rotations_.pop_back();
+        colors_.pop_back();
+        animations_.pop_back();
+        indices.erase(id);
+        version = nextVersion();
+    }
+
+    void LardEntityStore::clear() {
+        ids_.clear();
+        models_.clear();
+        translations_.clear();
+        scales_.clear();
+        rotations_.clear();
+        colors_.clear();
+        animations_.clear();
+        indices.clear();
+        modelSlots.clear();
+        freeModelSlots.clear();
+        modelHandles.clear();
+        version = nextVersion();
+    }
+
+    void LardEntityStore::reserve(size_t capacity) {
+        ids_.reserve(capacity);
+        models_.reserve(capacity);
+        translations_.reserve(capacity);
+        scales_.reserve(capacity);
+        rotations_.reserve(capacity);
+        colors_.reserve(capacity);
+        animations_.reserve(capacity);
+        indices.reserve(capacity);
+    }
+
+    size_t LardEntityStore::indexOf(id_t id) const {
+        auto it = indices.find(id);
+        if (it == indices.end()) {
+            throw std::runtime_error("entity not in the store");
+        }
+        return it->second;
+    }
+
+    void LardEntityStore::setModel(size_t index, std::shared_ptr<LardModel> model) {
+        assert(index < ids_.size() && "Entity index out of range");
+        // acquire first, the entity may already use this model
+        ModelHandle handle = acquireModel(std::move(model));
+        releaseModel(models_[index]);
+        models_[index] = handle;
+        version = nextVersion();
+    }
+
+    LardEntityStore::ModelHandle LardEntityStore::acquireModel(std::shared_ptr<LardModel> model) {
+        assert(model != nullptr && "Entities need a model");
+        auto it = modelHandles.find(model.get());
+        if (it != modelHandles.end()) {
+            modelSlots[it->second].refCount++;
+            return it->second;
+        }
+
+        ModelHandle handle;
+        if (!freeModelSlots.empty()) {
+            handle = freeModelSlots.back();
+            freeModelSlots.pop_back();
+        } else {
+            handle = static_cast<ModelHandle>(modelSlots.size());
+            modelSlots.emplace_back();
+        }
+        modelHandles.emplace(model.get(), handle);
+        modelSlots[handle].model = std::move(model);
+        modelSlots[handle].refCount = 1;
+        return handle;
+    }
+
+    void LardEntityStore::releaseModel(ModelHandle handle) {
+        auto& slot = modelSlots[handle];
+        if (--slot.refCount == 0) {
+            modelHandles.erase(slot.model.get());
+            slot.model.reset();
+            freeModelSlots.push_back(handle);
+        }
+    }
+
+}  // namespace lard
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "lard_game_object.hpp"
+#include "lard_model.hpp"
+
+// std lib headers
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace lard {
+
+    // One component of every entity in a store, contiguous and in the store's dense order.
+    template <typename T>
+    class LardComponentView {
+    public:
+        LardComponentView(T* data, size_t size) : data_{ data }, size_{ size } {}
+
+        T* data() const { return data_; }
+        size_t size() const { return size_; }
+        T& operator[](size_t index) const { return data_[index]; }
+        T* begin() const { return data_; }
+        T* end() const { return data_ + size_; }
+
+    private:
+        T* data_;
+        size_t size_;
+    };
+
+    // Game objects as a structure of arrays: every component lives in its own densely packed
+    // array, all indexed by the entity's position, so a system only streams the components it
+    // reads. Models are referenced through small handles, the store holds the one reference per
+    // model instead of one per entity. Removing moves the last entity into the hole, so positions
+    // change while ids stay.
+    class LardEntityStore {
+    public:
+        using id_t = LardGameObject::id_t;
+        using ModelHandle = uint32_t;
+
+        LardEntityStore() = default;
+        LardEntityStore(const LardEntityStore&) = delete;
+        LardEntityStore& operator=(const LardEntityStore&) = delete;
+
+        // takes over object's components, the entity keeps object's id
+        id_t add(LardGameObject&& object);
+        void remove(id_t id);
+        void clear();
+        void reserve(size_t capacity);
+
+        bool contains(id_t id) const { return indices.count(id) != 0; }
+        // the entity's position in every component array
+        size_t indexOf(id_t id) const;
+        size_t size() const { return ids_.size(); }
+        bool empty() const { return ids_.empty(); }
+        // changes with every add, remove, clear and setModel, not with writes through the views;
+        // drawn from a process wide counter, so no two stores ever share a version
+        uint64_t getVersion() const { return version; }
+
+        LardModel* getModel(ModelHandle handle) const { return modelSlots[handle].model.get(); }
+        // every handle is below this, for arrays indexed by handle
+        uint32_t getModelSlotCount() const { return static_cast<uint32_t>(modelSlots.size()); }
+        void setModel(size_t index, std::shared_ptr<LardModel> model);
+
+        LardComponentView<const id_t> ids() const { return { ids_.data(), ids_.size() }; }
+        LardComponentView<const ModelHandle> models() const { return { models_.data(), models_.size() }; }
+        LardComponentView<glm::vec2> translations() { return { translations_.data(), translations_.size() }; }
+        LardComponentView<const glm::vec2> translations() const { return { translations_.data(), translations_.size() }; }
+        LardComponentView<glm::vec2> scales() { return { scales_.data(), scales_.size() }; }
+        LardComponentView<const glm::vec2> scales() const { return { scales_.data(), scales_.size() }; }
+        LardComponentView<float> rotations() { return { rotations_.data(), rotations_.size() }; }
+        LardComponentView<const float> rotations() const { return { rotations_.data(), rotations_.size() }; }
+        LardComponentView<glm::vec3> colors() { return { colors_.data(), colors_.size() }; }
+        LardComponentView<const glm::vec3> colors() const { return { colors_.data(), colors_.size() }; }
+        LardComponentView<AnimationComponent> animations() { return { animations_.data(), animations_.size() }; }
+        LardComponentView<const AnimationComponent> animations() const { return { animations_.data(), animations_.size() }; }
+
+    private:
+        struct ModelSlot {
+            std::shared_ptr<LardModel> model;
+            uint32_t refCount = 0;
+        };
+
+        static uint64_t nextVersion();
+        ModelHandle acquireModel(std::shared_ptr<LardModel> model);
+        void releaseModel(ModelHandle handle);
+
+        std::vector<id_t> ids_;
+        std::vector<ModelHandle> models_;
+        std::vector<glm::vec2> translations_;
+        std::vector<glm::vec2> scales_;
+        std::vector<float> rotations_;
+        std::vector<glm::vec3> colors_;
+        std::vector<AnimationComponent> animations_;
+        std::unordered_map<id_t, size_t> indices;
+
+        std::vector<ModelSlot> modelSlots;
+        std::vector<ModelHandle> freeModelSlots;
+        std::unordered_map<LardModel*, ModelHandle> modelHandles;
+        uint64_t version = nextVersion();
+    };
+
+}  // namespace lard
@@ -0,0 +1,56 @@
+#include "lard_frame_allocator.hpp"
+
+// std headers
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lard {
+
+    LardFrameAllocator::LardFrameAllocator(LardDevice& device, uint32_t frameCount, VkDeviceSize frameSize)
+        : lardDevice{ device }, frameSize{ frameSize } {
+        const auto& limits = lardDevice.properties.limits;
+        uniformAlignment = std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, 16);
+        storageAlignment = std::max<VkDeviceSize>(limits.minStorageBufferOffsetAlignment, 16);
+
+        frames.resize(frameCount);
+        for (auto& frame : frames) {
+            lardDevice.createBuffer(
+                frameSize,
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                frame.buffer,
+                frame.allocation);
+        }
+    }
+
+    LardFrameAllocator::~LardFrameAllocator() {
+        for (auto& frame : frames) {
+            lardDevice.destroyBuffer(frame.buffer, frame.allocation);
+        }
+    }
+
+    void LardFrameAllocator::beginFrame(uint32_t frameIndex) {
+        assert(frameIndex < frames.size() && "Frame index out of range");
+        currentFrame = frameIndex;
+        head = 0;
+    }
+
+    LardFrameAllocation LardFrameAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+        // all alignments Vulkan reports are powers of two
+        VkDeviceSize offset = (head + alignment - 1) & ~(alignment - 1);
+        if (offset + size > frameSize) {
+            throw std::runtime_error("frame allocator out of memory!");
+        }
+        head = offset + size;
+
+        auto& frame = frames[currentFrame];
+        LardFrameAllocation allocation{};
+        allocation.buffer = frame.buffer;
+        allocation.offset = offset;
+        allocation.data = static_cast<char*>(frame.allocation.mappedData) + offset;
+        return allocation;
+    }
+
+}  // namespace lard
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "lard_device.hpp"
+
+// std lib headers
+#include <vector>
+
+namespace lard {
+
+    // A slice of the current frame's transient buffer. data stays valid until the frame slot
+    // comes around again, bind buffer at offset to read it on the GPU.
+    struct LardFrameAllocation {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        void* data = nullptr;
+    };
+
+    // Bump allocator for data that only lives for one frame: one persistently mapped buffer per
+    // frame in flight, rewound by beginFrame() once the slot's previous frame has completed on the
+    // frame timeline semaphore. Allocating is a pointer bump, nothing is mapped, freed or created
+    // while recording.
+    class LardFrameAllocator {
+    public:
+        // room for instance data of a few hundred thousand objects
+        static constexpr VkDeviceSize DEFAULT_FRAME_SIZE = 16 * 1024 * 1024;
+
+        LardFrameAllocator(LardDevice& device, uint32_t frameCount, VkDeviceSize frameSize = DEFAULT_FRAME_SIZE);
+        ~LardFrameAllocator();
+        LardFrameAllocator(const LardFrameAllocator&) = delete;
+        LardFrameAllocator& operator=(const LardFrameAllocator&) = delete;
+
+        // the GPU must be done with frameIndex, everything handed out for it is overwritten
+        void beginFrame(uint32_t frameIndex);
+
+        LardFrameAllocation allocate(VkDeviceSize size, VkDeviceSize alignment);
+        LardFrameAllocation allocateUniform(VkDeviceSize size) { return allocate(size, uniformAlignment); }
+        LardFrameAllocation allocateStorage(VkDeviceSize size) { return allocate(size, storageAlignment); }
+        LardFrameAllocation allocateVertex(VkDeviceSize size) { return allocate(size, 16); }
+        LardFrameAllocation allocateIndex(VkDeviceSize size) { return allocate(size, 4); }
+
+        VkDeviceSize getFrameSize() const { return frameSize; }
+        VkDeviceSize getUsedBytes() const { return head; }
+
+    private:
+        struct FrameBuffer {
+            VkBuffer buffer;
+            LardAllocation allocation;
+        };
+
+        LardDevice& lardDevice;
+        std::vector<FrameBuffer> frames;
+        VkDeviceSize frameSize;
+        VkDeviceSize uniformAlignment;
+        VkDeviceSize storageAlignment;
+
+        uint32_t currentFrame = 0;
+        VkDeviceSize head = 0;
+    };
+
+}  // namespace lard
@@ -9,7 +9,9 @@ namespace lard {
         glm::vec2 translation{};
         glm::vec2 scale{1.f, 1.f};
         float rotation;
-        glm::mat2 mat2() {
+        glm::mat2 mat2() const { return matrix(rotation, scale); }
+        // for transforms stored component by component, as in LardEntityStore
+        static glm::mat2 matrix(float rotation, glm::vec2 scale) {
             const float s = glm::sin(rotation);
             const float c = glm::cos(rotation);
             glm::mat2 rotMatrix{{c, s}, {-s, c}};
@@ -18,6 +20,16 @@ namespace lard {
         }
     };
 
+    // Procedural motion on top of transform2d, evaluated on the GPU by SimpleRenderSystem's GPU
+    // driven path from the time alone, so the CPU never steps it.
+    struct AnimationComponent {
+        float rotationSpeed = 0.f;   // radians per second
+        glm::vec2 swayAmplitude{};   // translation swings back and forth along this
+        float swaySpeed = 0.f;       // radians per second
+        float pulseAmount = 0.f;     // scale swings by this fraction
+        float pulseSpeed = 0.f;      // radians per second
+    };
+
     class LardGameObject {
         public:
         using id_t = unsigned int;
@@ -35,6 +47,7 @@ namespace lard {
         std::shared_ptr<LardModel> model{};
         glm::vec3 color{};
         Transform2dComponent transform2d;
+        AnimationComponent animation{};
 
         
 
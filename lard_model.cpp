@@ -1,45 +1,132 @@
 #include "lard_model.hpp"
+#include "lard_uploader.hpp"
 
 // std
 #include <cassert>
 #include <cstring>
+#include <functional>
+#include <limits>
 
 namespace lard {
 
-    LardModel::LardModel(LardDevice &device, const std::vector<Vertex> &vertices) : lardDevice{device} {
-        createVertexBuffers(vertices);
+    LardModel::LardModel(LardDevice &device, const std::vector<Vertex> &vertices, Placement placement) : lardDevice{device} {
+        createVertexBuffers(vertices, placement);
+    }
+
+    LardModel::LardModel(LardDevice &device, const Builder &builder, Placement placement) : lardDevice{device} {
+        createVertexBuffers(builder.vertices, placement);
+        createIndexBuffers(builder.indices, placement);
     }
 
     LardModel::~LardModel() {
-        vkDestroyBuffer(lardDevice.device(), vertexBuffer, nullptr);
-        vkFreeMemory(lardDevice.device(), vertexBufferMemory, nullptr);
+        lardDevice.deferDestroyBuffer(vertexBuffer, vertexBufferAllocation, uploadToken);
+        if (hasIndexBuffer) {
+            lardDevice.deferDestroyBuffer(indexBuffer, indexBufferAllocation, uploadToken);
+        }
     }
 
-    void LardModel::createVertexBuffers(const std::vector<Vertex> &vertices) {
+    void LardModel::createVertexBuffers(const std::vector<Vertex> &vertices, Placement placement) {
         vertexCount = static_cast<uint32_t>(vertices.size());
         assert(vertexCount >= 3 && "Vertex count must be at least 3");
         VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;
-        lardDevice.createBuffer(
+
+        boundsMin = boundsMax = vertices[0].position;
+        for (const auto &vertex : vertices) {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
+
+        createGeometryBuffer(
+            vertices.data(),
             bufferSize,
             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            placement,
             vertexBuffer,
-            vertexBufferMemory);
+            vertexBufferAllocation);
+    }
 
-        void *data;
-        vkMapMemory(lardDevice.device(), vertexBufferMemory, 0, bufferSize, 0, &data);
-        memcpy(data, vertices.data(), static_cast<size_t>(bufferSize));
-        vkUnmapMemory(lardDevice.device(), vertexBufferMemory);
+    void LardModel::createIndexBuffers(const std::vector<uint32_t> &indices, Placement placement) {
+        indexCount = static_cast<uint32_t>(indices.size());
+        hasIndexBuffer = indexCount > 0;
+        if (!hasIndexBuffer) {
+            return;
+        }
+        assert(indexCount >= 3 && "Index count must be at least 3");
+
+        // half the index bandwidth for anything up to 65535 vertices
+        if (vertexCount <= std::numeric_limits<uint16_t>::max()) {
+            indexType = VK_INDEX_TYPE_UINT16;
+            std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+            createGeometryBuffer(
+                shortIndices.data(),
+                sizeof(uint16_t) * indexCount,
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+                placement,
+                indexBuffer,
+                indexBufferAllocation);
+            return;
+        }
+
+        indexType = VK_INDEX_TYPE_UINT32;
+        createGeometryBuffer(
+            indices.data(),
+            sizeof(uint32_t) * indexCount,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            placement,
+            indexBuffer,
+            indexBufferAllocation);
     }
 
-    void LardModel::draw(VkCommandBuffer commandBuffer) {
-        vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);
+    // the uploader copies data into its staging ring right away, so data may be a temporary
+    void LardModel::createGeometryBuffer(
+        const void *data,
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        Placement placement,
+        VkBuffer &buffer,
+        LardAllocation &bufferAllocation) {
+        if (placement == Placement::HostVisible) {
+            lardDevice.createBuffer(
+                size,
+                usage,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                buffer,
+                bufferAllocation);
+
+            memcpy(bufferAllocation.mappedData, data, static_cast<size_t>(size));
+            return;
+        }
+
+        lardDevice.createBuffer(
+            size,
+            usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            buffer,
+            bufferAllocation);
+
+        uploadToken = lardDevice.uploader().uploadBuffer(buffer, 0, data, size);
+    }
+
+    bool LardModel::isReady() const {
+        return lardDevice.uploader().isComplete(uploadToken);
+    }
+
+    void LardModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance) {
+        if (hasIndexBuffer) {
+            vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, 0, 0, firstInstance);
+        } else {
+            vkCmdDraw(commandBuffer, vertexCount, instanceCount, 0, firstInstance);
+        }
     }
 
     void LardModel::bind(VkCommandBuffer commandBuffer) {
         VkBuffer buffers[] = {vertexBuffer};
         VkDeviceSize offsets[] = {0};
         vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+
+        if (hasIndexBuffer) {
+            vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, indexType);
+        }
     }
 
     std::vector<VkVertexInputBindingDescription> LardModel::Vertex::getBindingDescriptions() {
@@ -66,4 +153,34 @@ namespace lard {
 
         return attributeDescriptions;
     }
+
+    size_t LardModel::VertexHash::operator()(const Vertex &vertex) const {
+        // equal vertices must hash equal, std::hash<float> maps 0.0 and -0.0 to the same value
+        size_t seed = 0;
+        auto combine = [&seed](float value) {
+            seed ^= std::hash<float>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        };
+        combine(vertex.position.x);
+        combine(vertex.position.y);
+        combine(vertex.color.x);
+        combine(vertex.color.y);
+        combine(vertex.color.z);
+        return seed;
+    }
+
+    LardModel::Builder::Builder(const std::vector<Vertex> &triangleList) {
+        uniqueVertices.reserve(triangleList.size());
+        indices.reserve(triangleList.size());
+        for (const auto &vertex : triangleList) {
+            addVertex(vertex);
+        }
+    }
+
+    void LardModel::Builder::addVertex(const Vertex &vertex) {
+        auto [it, inserted] = uniqueVertices.try_emplace(vertex, static_cast<uint32_t>(vertices.size()));
+        if (inserted) {
+            vertices.push_back(vertex);
+        }
+        indices.push_back(it->second);
+    }
 }
\ No newline at end of file
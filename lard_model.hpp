@@ -3,6 +3,7 @@
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
+#include <unordered_map>
 #include <vector>
 
 #include "lard_device.hpp"
@@ -17,23 +18,85 @@ namespace lard {
 
                 static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
                 static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+
+                bool operator==(const Vertex &other) const {
+                    return position == other.position && color == other.color;
+                }
+            };
+
+            struct VertexHash {
+                size_t operator()(const Vertex &vertex) const;
             };
 
-            LardModel(LardDevice &device, const std::vector<Vertex> &vertices);
+            // Collects indexed geometry. addVertex welds a vertex equal to one added before into
+            // the same index, so meshes built from triangle lists store every corner once and
+            // the post-transform cache can reuse its vertex shader result.
+            class Builder {
+                public:
+                    std::vector<Vertex> vertices{};
+                    std::vector<uint32_t> indices{};
+
+                    Builder() = default;
+                    // welds a non-indexed triangle list
+                    explicit Builder(const std::vector<Vertex> &triangleList);
+
+                    void addVertex(const Vertex &vertex);
+
+                private:
+                    std::unordered_map<Vertex, uint32_t, VertexHash> uniqueVertices{};
+            };
+
+            // DeviceLocal geometry is filled through the device's staging ring, HostVisible is
+            // written in place and read by the GPU over the bus on discrete cards.
+            enum class Placement { DeviceLocal, HostVisible };
+
+            LardModel(LardDevice &device, const std::vector<Vertex> &vertices, Placement placement = Placement::DeviceLocal);
+            // indices are stored as 16 bit when every vertex can be addressed with them
+            LardModel(LardDevice &device, const Builder &builder, Placement placement = Placement::DeviceLocal);
             ~LardModel();
             LardModel(const LardModel &) = delete;
             LardModel &operator=(const LardModel &) = delete;
 
             void bind(VkCommandBuffer commandBuffer);
-            void draw(VkCommandBuffer commandBuffer);
+            void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+
+            // false while the vertex upload is still in flight on the transfer queue
+            bool isReady() const;
+
+            uint32_t getVertexCount() const { return vertexCount; }
+            // 0 for non-indexed models
+            uint32_t getIndexCount() const { return indexCount; }
+            bool isIndexed() const { return hasIndexBuffer; }
+            // model space bounding box of the vertex positions
+            glm::vec2 getBoundsMin() const { return boundsMin; }
+            glm::vec2 getBoundsMax() const { return boundsMax; }
 
         private:
-            void createVertexBuffers(const std::vector<Vertex> &vertices);
+            void createVertexBuffers(const std::vector<Vertex> &vertices, Placement placement);
+            void createIndexBuffers(const std::vector<uint32_t> &indices, Placement placement);
+            void createGeometryBuffer(
+                const void *data,
+                VkDeviceSize size,
+                VkBufferUsageFlags usage,
+                Placement placement,
+                VkBuffer &buffer,
+                LardAllocation &bufferAllocation);
 
             LardDevice &lardDevice;
             VkBuffer vertexBuffer;
-            VkDeviceMemory vertexBufferMemory;
+            LardAllocation vertexBufferAllocation;
             uint32_t vertexCount;
+            glm::vec2 boundsMin{};
+            glm::vec2 boundsMax{};
+
+            bool hasIndexBuffer = false;
+            VkBuffer indexBuffer = VK_NULL_HANDLE;
+            LardAllocation indexBufferAllocation{};
+            uint32_t indexCount = 0;
+            VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+            // uploads are flushed together, the last token also covers the earlier ones
+            LardUploadToken uploadToken;
     };
 
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "lard_pipeline.hpp"
 #include "lard_model.hpp"
+#include "lard_shader_registry.hpp"
 
-#include <fstream>
 #include <iostream>
 #include <stdexcept>
 #include <cassert>
@@ -9,10 +9,10 @@
 namespace lard {
 
     LardPipeline::LardPipeline(LardDevice &device,
-                const std::string &vertFilepath,
-                const std::string &fragFilepath,
+                const std::string &vertShader,
+                const std::string &fragShader,
                 const PipelineConfigInfo &configInfo) : lardDevice(device) {
-        createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);
+        createGraphicsPipeline(vertShader, fragShader, configInfo);
     }
 
     LardPipeline::~LardPipeline() {
@@ -22,42 +22,27 @@ namespace lard {
 
     }
 
-    std::vector<char> LardPipeline::readFile(const std::string &filepath) {
-        std::ifstream file{
-            filepath,
-            std::ios::ate | std::ios::binary
-        };
-
-        if (!file.is_open()) {
-            throw std::runtime_error("Failed to open file: " + filepath);
-        }
-
-        size_t fileSize = static_cast<size_t>(file.tellg());
-        std::vector<char> buffer(fileSize);
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-        file.close();
-        
-        return buffer;
-    }
-
-    void LardPipeline::createGraphicsPipeline(const std::string &vertFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo) {
+    void LardPipeline::createGraphicsPipeline(const std::string &vertShader, const std::string &fragShader, const PipelineConfigInfo &configInfo) {
         
         assert(
             configInfo.pipelineLayout != nullptr &&
             "Cannot create graphics pipeline: no pipelineLayout provided in config info");
         assert(
-            configInfo.renderPass != nullptr &&
-            "Cannot create graphics pipeline: no renderPass provided in config info");
-        auto vertCode = readFile(vertFilepath);
-        auto fragCode = readFile(fragFilepath);
+            (configInfo.renderPass != nullptr || configInfo.colorAttachmentFormat != VK_FORMAT_UNDEFINED) &&
+            "Cannot create graphics pipeline: no renderPass or attachment formats provided in config info");
+        auto vertCode = LardShaderRegistry::get(vertShader);
+        auto fragCode = LardShaderRegistry::get(fragShader);
 
-        //std::cout << "Vertex shader code size: " << vertCode.size() << "\n";
-        //std::cout << "Fragment shader code size: " << fragCode.size() << "\n";
+        //std::cout << "Vertex shader code size: " << vertCode.size << "\n";
+        //std::cout << "Fragment shader code size: " << fragCode.size << "\n";
 
         createShaderModule(vertCode, &vertSaherModule);
         createShaderModule(fragCode, &fragShaderModule);
 
+        VkSpecializationInfo specializationInfo = configInfo.specialization.getInfo();
+        const VkSpecializationInfo* pSpecializationInfo =
+            configInfo.specialization.empty() ? nullptr : &specializationInfo;
+
         VkPipelineShaderStageCreateInfo shaderStages[2];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
@@ -65,17 +50,17 @@ namespace lard {
         shaderStages[0].pName = "main";
         shaderStages[0].flags = 0;
         shaderStages[0].pNext = nullptr;
-        shaderStages[0].pSpecializationInfo = nullptr;
+        shaderStages[0].pSpecializationInfo = pSpecializationInfo;
         shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
         shaderStages[1].module = fragShaderModule;
         shaderStages[1].pName = "main";
         shaderStages[1].flags = 0;
         shaderStages[1].pNext = nullptr;
-        shaderStages[1].pSpecializationInfo = nullptr;
+        shaderStages[1].pSpecializationInfo = pSpecializationInfo;
 
-        auto bindingDescriptions = LardModel::Vertex::getBindingDescriptions();
-        auto attributeDescriptions = LardModel::Vertex::getAttributeDescriptions();
+        auto& bindingDescriptions = configInfo.bindingDescriptions;
+        auto& attributeDescriptions = configInfo.attributeDescriptions;
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
         vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
@@ -101,10 +86,19 @@ namespace lard {
         pipelineInfo.renderPass = configInfo.renderPass;
         pipelineInfo.subpass = configInfo.subpass;
 
+        VkPipelineRenderingCreateInfoKHR renderingInfo{};
+        if (configInfo.renderPass == nullptr) {
+            renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+            renderingInfo.colorAttachmentCount = 1;
+            renderingInfo.pColorAttachmentFormats = &configInfo.colorAttachmentFormat;
+            renderingInfo.depthAttachmentFormat = configInfo.depthAttachmentFormat;
+            pipelineInfo.pNext = &renderingInfo;
+        }
+
         pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        if (vkCreateGraphicsPipelines(lardDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines(lardDevice.device(), lardDevice.pipelineCache(), 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create graphics pipeline");
         }
 
@@ -112,11 +106,11 @@ namespace lard {
 
     }
 
-    void  LardPipeline::createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule) {
+    void  LardPipeline::createShaderModule(const LardShaderCode &code, VkShaderModule *shaderModule) {
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+        createInfo.codeSize = code.size;
+        createInfo.pCode = code.code;
 
         if (vkCreateShaderModule(lardDevice.device(), &createInfo, nullptr, shaderModule) != VK_SUCCESS) {
             throw std::runtime_error("Failed to create shader module");
@@ -195,6 +189,36 @@ namespace lard {
         configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
         configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
         configInfo.dynamicStateInfo.flags = 0;
+
+        configInfo.bindingDescriptions = LardModel::Vertex::getBindingDescriptions();
+        configInfo.attributeDescriptions = LardModel::Vertex::getAttributeDescriptions();
+    }
+
+    void LardPipeline::copyPipelineConfigInfo(const PipelineConfigInfo& src, PipelineConfigInfo& dst) {
+        dst.bindingDescriptions = src.bindingDescriptions;
+        dst.attributeDescriptions = src.attributeDescriptions;
+        dst.viewportInfo = src.viewportInfo;
+        dst.inputAssemblyInfo = src.inputAssemblyInfo;
+        dst.rasterizationInfo = src.rasterizationInfo;
+        dst.multisampleInfo = src.multisampleInfo;
+        dst.colorBlendAttachment = src.colorBlendAttachment;
+        dst.colorBlendInfo = src.colorBlendInfo;
+        dst.depthStencilInfo = src.depthStencilInfo;
+        dst.dynamicStateEnables = src.dynamicStateEnables;
+        dst.dynamicStateInfo = src.dynamicStateInfo;
+        dst.pipelineLayout = src.pipelineLayout;
+        dst.renderPass = src.renderPass;
+        dst.subpass = src.subpass;
+        dst.colorAttachmentFormat = src.colorAttachmentFormat;
+        dst.depthAttachmentFormat = src.depthAttachmentFormat;
+        dst.specialization = src.specialization;
+
+        if (src.colorBlendInfo.pAttachments == &src.colorBlendAttachment) {
+            dst.colorBlendInfo.pAttachments = &dst.colorBlendAttachment;
+        }
+        if (src.dynamicStateInfo.pDynamicStates == src.dynamicStateEnables.data()) {
+            dst.dynamicStateInfo.pDynamicStates = dst.dynamicStateEnables.data();
+        }
     }
 
 }
\ No newline at end of file
@@ -1,16 +1,69 @@
 #pragma once
 
 #include "lard_device.hpp"
+#include "lard_shader_registry.hpp"
 
+#include <cassert>
+#include <cstring>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace lard {
 
+    // Typed specialization constant values, applied to every shader stage of a pipeline. Stages
+    // ignore constant IDs they do not declare, so one set serves the whole pipeline.
+    class LardSpecialization {
+    public:
+        // bool is stored as VkBool32 as SPIR-V expects
+        LardSpecialization& set(uint32_t constantId, bool value) {
+            return set(constantId, static_cast<VkBool32>(value ? VK_TRUE : VK_FALSE));
+        }
+        template <typename T>
+        LardSpecialization& set(uint32_t constantId, T value) {
+            static_assert(std::is_arithmetic<T>::value && (sizeof(T) == 4 || sizeof(T) == 8),
+                "specialization constants are 32 or 64 bit scalars");
+            for (auto& entry : entries) {
+                if (entry.constantID == constantId) {
+                    assert(entry.size == sizeof(T) && "Specialization constant set with another type");
+                    std::memcpy(&data[entry.offset], &value, sizeof(T));
+                    return *this;
+                }
+            }
+            VkSpecializationMapEntry entry{};
+            entry.constantID = constantId;
+            entry.offset = static_cast<uint32_t>(data.size());
+            entry.size = sizeof(T);
+            entries.push_back(entry);
+            data.resize(data.size() + sizeof(T));
+            std::memcpy(&data[entry.offset], &value, sizeof(T));
+            return *this;
+        }
+
+        bool empty() const { return entries.empty(); }
+        const std::vector<VkSpecializationMapEntry>& getEntries() const { return entries; }
+        const std::vector<uint8_t>& getData() const { return data; }
+        // points into this object, keep it alive and unchanged while the info is used
+        VkSpecializationInfo getInfo() const {
+            VkSpecializationInfo info{};
+            info.mapEntryCount = static_cast<uint32_t>(entries.size());
+            info.pMapEntries = entries.data();
+            info.dataSize = data.size();
+            info.pData = data.data();
+            return info;
+        }
+
+    private:
+        std::vector<VkSpecializationMapEntry> entries;
+        std::vector<uint8_t> data;
+    };
+
     struct PipelineConfigInfo {
         PipelineConfigInfo(const PipelineConfigInfo&) = delete;
         PipelineConfigInfo& operator=(const PipelineConfigInfo&) = delete;
         
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
         VkPipelineViewportStateCreateInfo viewportInfo;
         VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo;
         VkPipelineRasterizationStateCreateInfo rasterizationInfo;
@@ -23,25 +76,47 @@ namespace lard {
         VkPipelineLayout pipelineLayout = nullptr;
         VkRenderPass renderPass = nullptr;
         uint32_t subpass = 0;
+        // used instead of renderPass when it is null, the pipeline then targets dynamic rendering
+        VkFormat colorAttachmentFormat = VK_FORMAT_UNDEFINED;
+        VkFormat depthAttachmentFormat = VK_FORMAT_UNDEFINED;
+        // the variant of the shaders to compile, part of the pipeline's identity
+        LardSpecialization specialization{};
 };
 
+    // What pipelines drawing into a render target are built against: its render pass, or just
+    // its attachment formats when it is drawn with dynamic rendering.
+    struct LardRenderTargetInfo {
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkFormat colorFormat = VK_FORMAT_UNDEFINED;
+        VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+
+        void apply(PipelineConfigInfo& configInfo) const {
+            configInfo.renderPass = renderPass;
+            configInfo.colorAttachmentFormat = colorFormat;
+            configInfo.depthAttachmentFormat = depthFormat;
+        }
+    };
+
     class LardPipeline {
         public:
+            // vertShader and fragShader are LardShaderRegistry names, e.g. "simple_shader.vert"
             LardPipeline(LardDevice &device,
-                const std::string &vertFilepath,
-                const std::string &fragFilepath,
+                const std::string &vertShader,
+                const std::string &fragShader,
                 const PipelineConfigInfo &configInfo);
             ~LardPipeline();
             LardPipeline(const LardPipeline&) = delete;
             LardPipeline& operator=(const LardPipeline&) = delete;
             void bind(VkCommandBuffer commandBuffer);
             static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
+            // copies src into dst and re-points dst's internal pointers at dst's own members,
+            // PipelineConfigInfo is not copyable because a plain copy would keep pointing into src
+            static void copyPipelineConfigInfo(const PipelineConfigInfo& src, PipelineConfigInfo& dst);
         private:
-            static std::vector<char> readFile(const std::string &filepath);
-            void createGraphicsPipeline(const std::string &vertFilepath,
-                const std::string &fragFilepath,
+            void createGraphicsPipeline(const std::string &vertShader,
+                const std::string &fragShader,
                 const PipelineConfigInfo &configInfo);
-            void createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule);
+            void createShaderModule(const LardShaderCode &code, VkShaderModule *shaderModule);
             LardDevice &lardDevice;
             VkPipeline graphicsPipeline;
             VkShaderModule vertSaherModule;
@@ -0,0 +1,85 @@
+#include "lard_pipeline_compiler.hpp"
+
+// std headers
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <thread>
+
+namespace lard {
+
+    void LardAsyncPipeline::wait() const {
+        std::unique_lock<std::mutex> lock{ mutex };
+        finished.wait(lock, [this] { return state.load(std::memory_order_acquire) != State::Compiling; });
+    }
+
+    void LardAsyncPipeline::finish(std::unique_ptr<LardPipeline> result, std::string message) {
+        {
+            std::lock_guard<std::mutex> lock{ mutex };
+            pipeline = std::move(result);
+            error = std::move(message);
+            // published last, get() never sees a half written pipeline
+            state.store(pipeline ? State::Ready : State::Failed, std::memory_order_release);
+        }
+        finished.notify_all();
+    }
+
+    uint32_t LardPipelineCompiler::defaultThreadCount() {
+        return std::max(1u, std::thread::hardware_concurrency() / 2);
+    }
+
+    LardPipelineCompiler::LardPipelineCompiler(LardDevice& device, uint32_t threadCount)
+        : lardDevice{ device }, threadPool{ threadCount != 0 ? threadCount : defaultThreadCount() } {}
+
+    LardPipelineCompiler::~LardPipelineCompiler() {
+        // pipelines reference layouts and render passes owned elsewhere, never leave one running
+        threadPool.waitIdle();
+    }
+
+    LardPipelineHandle LardPipelineCompiler::compile(
+        const std::string& vertShader,
+        const std::string& fragShader,
+        const PipelineConfigInfo& configInfo) {
+        auto handle = std::make_shared<LardAsyncPipeline>();
+        std::shared_ptr<PipelineConfigInfo> config{ new PipelineConfigInfo{} };
+        LardPipeline::copyPipelineConfigInfo(configInfo, *config);
+        {
+            std::lock_guard<std::mutex> lock{ statsMutex };
+            stats.pendingCount++;
+        }
+
+        threadPool.submit([this, handle, config, vertShader, fragShader]() {
+            auto start = std::chrono::steady_clock::now();
+            std::unique_ptr<LardPipeline> pipeline;
+            std::string error;
+            try {
+                // vkCreateGraphicsPipelines and the pipeline cache are safe to use from any thread
+                pipeline = std::make_unique<LardPipeline>(lardDevice, vertShader, fragShader, *config);
+            } catch (const std::exception& e) {
+                error = e.what();
+                std::cerr << "pipeline " << vertShader << " + " << fragShader << " failed: " << error << std::endl;
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            {
+                std::lock_guard<std::mutex> lock{ statsMutex };
+                stats.pendingCount--;
+                stats.compileSeconds += seconds;
+                if (pipeline) {
+                    stats.compiledCount++;
+                } else {
+                    stats.failedCount++;
+                }
+            }
+            handle->finish(std::move(pipeline), std::move(error));
+        });
+        return handle;
+    }
+
+    LardPipelineCompiler::Stats LardPipelineCompiler::getStats() const {
+        std::lock_guard<std::mutex> lock{ statsMutex };
+        return stats;
+    }
+
+}  // namespace lard
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "lard_device.hpp"
+#include "lard_pipeline.hpp"
+#include "lard_thread_pool.hpp"
+
+// std lib headers
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace lard {
+
+    // A pipeline that is being built on the compiler's threads. Until isReady() render systems
+    // skip the draws that need it or draw with a fallback pipeline.
+    class LardAsyncPipeline {
+    public:
+        bool isReady() const { return state.load(std::memory_order_acquire) == State::Ready; }
+        bool hasFailed() const { return state.load(std::memory_order_acquire) == State::Failed; }
+        // null until ready
+        LardPipeline* get() const { return isReady() ? pipeline.get() : nullptr; }
+        // blocks until the pipeline is ready or has failed
+        void wait() const;
+        // why compilation failed, only valid once hasFailed()
+        const std::string& getError() const { return error; }
+
+    private:
+        friend class LardPipelineCompiler;
+        enum class State { Compiling, Ready, Failed };
+
+        void finish(std::unique_ptr<LardPipeline> result, std::string message);
+
+        std::atomic<State> state{ State::Compiling };
+        std::unique_ptr<LardPipeline> pipeline;
+        std::string error;
+        mutable std::mutex mutex;
+        mutable std::condition_variable finished;
+    };
+
+    using LardPipelineHandle = std::shared_ptr<LardAsyncPipeline>;
+
+    // Builds pipelines on its own worker threads, all of them through the device's pipeline
+    // cache, so startup and the first use of a material do not stall the frame loop.
+    class LardPipelineCompiler {
+    public:
+        struct Stats {
+            uint32_t compiledCount = 0;
+            uint32_t failedCount = 0;
+            uint32_t pendingCount = 0;
+            double compileSeconds = 0.0;  // summed over all workers
+        };
+
+        // threadCount 0 uses half the hardware threads, leaving the rest to recording
+        explicit LardPipelineCompiler(LardDevice& device, uint32_t threadCount = 0);
+        ~LardPipelineCompiler();
+        LardPipelineCompiler(const LardPipelineCompiler&) = delete;
+        LardPipelineCompiler& operator=(const LardPipelineCompiler&) = delete;
+
+        // configInfo is copied, the pipeline layout and render pass it names must outlive the
+        // compilation, wait() on the handle before destroying them
+        LardPipelineHandle compile(
+            const std::string& vertShader,
+            const std::string& fragShader,
+            const PipelineConfigInfo& configInfo);
+        // blocks until everything submitted so far has finished
+        void waitIdle() { threadPool.waitIdle(); }
+
+        Stats getStats() const;
+
+    private:
+        static uint32_t defaultThreadCount();
+
+        LardDevice& lardDevice;
+        mutable std::mutex statsMutex;
+        Stats stats{};
+        // last member, its workers are joined before the rest is torn down
+        LardThreadPool threadPool;
+    };
+
+}  // namespace lard
@@ -0,0 +1,360 @@
+#include "lard_pipeline_registry.hpp"
+
+// std headers
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace lard {
+
+    namespace {
+        // Appends state field by field, never whole structs, so padding and pointers stay out of
+        // the key and equal states always produce equal bytes.
+        class KeyWriter {
+        public:
+            template <typename T>
+            void write(const T& value) {
+                static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "write fields, not structs");
+                key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+            }
+            void write(const std::string& value) {
+                write(static_cast<uint32_t>(value.size()));
+                key.append(value);
+            }
+            template <typename T>
+            void writeHandle(T handle) {
+                uint64_t value = 0;
+                std::memcpy(&value, &handle, sizeof(handle));
+                write(value);
+            }
+            void write(const VkStencilOpState& state) {
+                write(state.failOp);
+                write(state.passOp);
+                write(state.depthFailOp);
+                write(state.compareOp);
+                write(state.compareMask);
+                write(state.writeMask);
+                write(state.reference);
+            }
+
+            std::string key;
+        };
+    }
+
+    LardPipelineRef::LardPipelineRef(const LardPipelineRef& other)
+        : registry{ other.registry }, key{ other.key }, hash{ other.hash }, pipeline{ other.pipeline } {
+        if (registry != nullptr) {
+            registry->addRef(key);
+        }
+    }
+
+    LardPipelineRef& LardPipelineRef::operator=(const LardPipelineRef& other) {
+        if (this != &other) {
+            LardPipelineRef copy{ other };
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    LardPipelineRef::LardPipelineRef(LardPipelineRef&& other) noexcept
+        : registry{ other.registry }, key{ std::move(other.key) }, hash{ other.hash }, pipeline{ std::move(other.pipeline) } {
+        other.registry = nullptr;
+    }
+
+    LardPipelineRef& LardPipelineRef::operator=(LardPipelineRef&& other) noexcept {
+        if (this != &other) {
+            reset();
+            registry = other.registry;
+            key = std::move(other.key);
+            hash = other.hash;
+            pipeline = std::move(other.pipeline);
+            other.registry = nullptr;
+        }
+        return *this;
+    }
+
+    void LardPipelineRef::reset() {
+        if (registry != nullptr) {
+            registry->release(key);
+            registry = nullptr;
+        }
+        pipeline.reset();
+    }
+
+    LardPipelineRegistry::LardPipelineRegistry(LardDevice& device, LardPipelineCompiler& compiler)
+        : lardDevice{ device }, compiler{ compiler } {}
+
+    LardPipelineRegistry::~LardPipelineRegistry() {
+        assert(pipelines.empty() && "Pipeline refs must not outlive the registry");
+        // compilations may still read the layouts
+        compiler.waitIdle();
+        for (auto& kv : pipelineLayouts) {
+            vkDestroyPipelineLayout(lardDevice.device(), kv.second, nullptr);
+        }
+        for (auto& kv : descriptorSetLayouts) {
+            vkDestroyDescriptorSetLayout(lardDevice.device(), kv.second, nullptr);
+        }
+    }
+
+    VkDescriptorSetLayout LardPipelineRegistry::getDescriptorSetLayout(
+        const std::vector<VkDescriptorSetLayoutBinding>& bindings) {
+        KeyWriter writer;
+        writer.write(static_cast<uint32_t>(bindings.size()));
+        for (const auto& binding : bindings) {
+            assert(binding.pImmutableSamplers == nullptr && "Immutable samplers are not part of the key");
+            writer.write(binding.binding);
+            writer.write(binding.descriptorType);
+            writer.write(binding.descriptorCount);
+            writer.write(binding.stageFlags);
+        }
+
+        auto it = descriptorSetLayouts.find(writer.key);
+        if (it != descriptorSetLayouts.end()) {
+            return it->second;
+        }
+
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+        layoutInfo.pBindings = bindings.data();
+        VkDescriptorSetLayout setLayout;
+        if (vkCreateDescriptorSetLayout(lardDevice.device(), &layoutInfo, nullptr, &setLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create descriptor set layout!");
+        }
+        descriptorSetLayoutKeys.emplace(setLayout, writer.key);
+        descriptorSetLayouts.emplace(std::move(writer.key), setLayout);
+        return setLayout;
+    }
+
+    VkPipelineLayout LardPipelineRegistry::getPipelineLayout(
+        const std::vector<VkPushConstantRange>& pushConstantRanges,
+        const std::vector<VkDescriptorSetLayout>& setLayouts) {
+        KeyWriter writer;
+        writer.write(static_cast<uint32_t>(pushConstantRanges.size()));
+        for (const auto& range : pushConstantRanges) {
+            writer.write(range.stageFlags);
+            writer.write(range.offset);
+            writer.write(range.size);
+        }
+        writer.write(static_cast<uint32_t>(setLayouts.size()));
+        for (auto setLayout : setLayouts) {
+            // by contents when the registry made it, so the key stays the same across runs
+            auto known = descriptorSetLayoutKeys.find(setLayout);
+            if (known != descriptorSetLayoutKeys.end()) {
+                writer.write(uint8_t{ 1 });
+                writer.write(known->second);
+            } else {
+                writer.write(uint8_t{ 0 });
+                writer.writeHandle(setLayout);
+            }
+        }
+
+        auto it = pipelineLayouts.find(writer.key);
+        if (it != pipelineLayouts.end()) {
+            return it->second;
+        }
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+        pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+        pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+        VkPipelineLayout pipelineLayout;
+        if (vkCreatePipelineLayout(lardDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create pipeline layout!");
+        }
+        pipelineLayoutKeys.emplace(pipelineLayout, writer.key);
+        pipelineLayouts.emplace(std::move(writer.key), pipelineLayout);
+        return pipelineLayout;
+    }
+
+    std::string LardPipelineRegistry::makeKey(
+        const std::string& vertShader,
+        const std::string& fragShader,
+        const PipelineConfigInfo& configInfo) const {
+        KeyWriter writer;
+
+        writer.write(vertShader);
+        writer.write(fragShader);
+
+        writer.write(static_cast<uint32_t>(configInfo.bindingDescriptions.size()));
+        for (const auto& binding : configInfo.bindingDescriptions) {
+            writer.write(binding.binding);
+            writer.write(binding.stride);
+            writer.write(binding.inputRate);
+        }
+        writer.write(static_cast<uint32_t>(configInfo.attributeDescriptions.size()));
+        for (const auto& attribute : configInfo.attributeDescriptions) {
+            writer.write(attribute.location);
+            writer.write(attribute.binding);
+            writer.write(attribute.format);
+            writer.write(attribute.offset);
+        }
+
+        writer.write(configInfo.inputAssemblyInfo.topology);
+        writer.write(configInfo.inputAssemblyInfo.primitiveRestartEnable);
+        writer.write(configInfo.viewportInfo.viewportCount);
+        writer.write(configInfo.viewportInfo.scissorCount);
+
+        const auto& raster = configInfo.rasterizationInfo;
+        writer.write(raster.depthClampEnable);
+        writer.write(raster.rasterizerDiscardEnable);
+        writer.write(raster.polygonMode);
+        writer.write(raster.cullMode);
+        writer.write(raster.frontFace);
+        writer.write(raster.depthBiasEnable);
+        writer.write(raster.depthBiasConstantFactor);
+        writer.write(raster.depthBiasClamp);
+        writer.write(raster.depthBiasSlopeFactor);
+        writer.write(raster.lineWidth);
+
+        const auto& multisample = configInfo.multisampleInfo;
+        writer.write(multisample.rasterizationSamples);
+        writer.write(multisample.sampleShadingEnable);
+        writer.write(multisample.minSampleShading);
+        writer.write(multisample.alphaToCoverageEnable);
+        writer.write(multisample.alphaToOneEnable);
+        // one mask word covers up to 32 samples
+        writer.write(multisample.pSampleMask != nullptr ? *multisample.pSampleMask : ~0u);
+
+        const auto& blend = configInfo.colorBlendInfo;
+        writer.write(blend.logicOpEnable);
+        writer.write(blend.logicOp);
+        writer.write(blend.attachmentCount);
+        for (uint32_t i = 0; i < blend.attachmentCount; i++) {
+            const auto& attachment = blend.pAttachments[i];
+            writer.write(attachment.blendEnable);
+            writer.write(attachment.srcColorBlendFactor);
+            writer.write(attachment.dstColorBlendFactor);
+            writer.write(attachment.colorBlendOp);
+            writer.write(attachment.srcAlphaBlendFactor);
+            writer.write(attachment.dstAlphaBlendFactor);
+            writer.write(attachment.alphaBlendOp);
+            writer.write(attachment.colorWriteMask);
+        }
+        for (float constant : blend.blendConstants) {
+            writer.write(constant);
+        }
+
+        const auto& depth = configInfo.depthStencilInfo;
+        writer.write(depth.depthTestEnable);
+        writer.write(depth.depthWriteEnable);
+        writer.write(depth.depthCompareOp);
+        writer.write(depth.depthBoundsTestEnable);
+        writer.write(depth.minDepthBounds);
+        writer.write(depth.maxDepthBounds);
+        writer.write(depth.stencilTestEnable);
+        writer.write(depth.front);
+        writer.write(depth.back);
+
+        writer.write(configInfo.dynamicStateInfo.dynamicStateCount);
+        for (uint32_t i = 0; i < configInfo.dynamicStateInfo.dynamicStateCount; i++) {
+            writer.write(configInfo.dynamicStateInfo.pDynamicStates[i]);
+        }
+
+        // render passes with the same attachment formats are compatible, a pipeline built
+        // against one works with all of them, e.g. across swap chain recreation
+        auto layoutKey = pipelineLayoutKeys.find(configInfo.pipelineLayout);
+        if (layoutKey != pipelineLayoutKeys.end()) {
+            writer.write(layoutKey->second);
+        } else {
+            writer.writeHandle(configInfo.pipelineLayout);
+        }
+        writer.write(configInfo.renderPass != VK_NULL_HANDLE);
+        writer.write(configInfo.subpass);
+        writer.write(configInfo.colorAttachmentFormat);
+        writer.write(configInfo.depthAttachmentFormat);
+
+        // by constant ID and value, the order constants were set in does not matter
+        auto entries = configInfo.specialization.getEntries();
+        std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.constantID < b.constantID; });
+        const auto& data = configInfo.specialization.getData();
+        writer.write(static_cast<uint32_t>(entries.size()));
+        for (const auto& entry : entries) {
+            writer.write(entry.constantID);
+            writer.write(static_cast<uint32_t>(entry.size));
+            for (size_t i = 0; i < entry.size; i++) {
+                writer.write(data[entry.offset + i]);
+            }
+        }
+
+        return std::move(writer.key);
+    }
+
+    uint64_t LardPipelineRegistry::hashKey(const std::string& key) {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : key) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t LardPipelineRegistry::hashState(
+        const std::string& vertShader,
+        const std::string& fragShader,
+        const PipelineConfigInfo& configInfo) const {
+        return hashKey(makeKey(vertShader, fragShader, configInfo));
+    }
+
+    LardPipelineRef LardPipelineRegistry::acquire(
+        const std::string& vertShader,
+        const std::string& fragShader,
+        const PipelineConfigInfo& configInfo) {
+        std::string key = makeKey(vertShader, fragShader, configInfo);
+        uint64_t hash = hashKey(key);
+
+        auto it = pipelines.find(key);
+        if (it != pipelines.end()) {
+            hits++;
+            it->second.refCount++;
+            return LardPipelineRef{ this, std::move(key), hash, it->second.pipeline };
+        }
+
+        misses++;
+        Entry entry{};
+        entry.pipeline = compiler.compile(vertShader, fragShader, configInfo);
+        entry.refCount = 1;
+        LardPipelineHandle pipeline = entry.pipeline;
+        pipelines.emplace(key, std::move(entry));
+        return LardPipelineRef{ this, std::move(key), hash, std::move(pipeline) };
+    }
+
+    void LardPipelineRegistry::addRef(const std::string& key) {
+        auto it = pipelines.find(key);
+        assert(it != pipelines.end() && "Pipeline ref to a released pipeline");
+        it->second.refCount++;
+    }
+
+    void LardPipelineRegistry::release(const std::string& key) {
+        auto it = pipelines.find(key);
+        assert(it != pipelines.end() && "Pipeline ref to a released pipeline");
+        if (--it->second.refCount > 0) {
+            return;
+        }
+        // frames in flight may still draw with it
+        lardDevice.deferDestroy([pipeline = std::move(it->second.pipeline)]() mutable { pipeline.reset(); });
+        pipelines.erase(it);
+    }
+
+    LardPipelineRegistry::Stats LardPipelineRegistry::getStats() const {
+        Stats stats{};
+        stats.hits = hits;
+        stats.misses = misses;
+        stats.pipelineCount = static_cast<uint32_t>(pipelines.size());
+        stats.pipelineLayoutCount = static_cast<uint32_t>(pipelineLayouts.size());
+        stats.descriptorSetLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
+        return stats;
+    }
+
+    void LardPipelineRegistry::printStats(std::ostream& out) const {
+        out << "pipeline registry: " << pipelines.size() << " pipelines, "
+            << pipelineLayouts.size() << " pipeline layouts, "
+            << descriptorSetLayouts.size() << " descriptor set layouts, "
+            << hits << " hits, " << misses << " misses" << std::endl;
+    }
+
+}  // namespace lard
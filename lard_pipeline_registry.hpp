@@ -0,0 +1,125 @@
+#pragma once
+
+#include "lard_device.hpp"
+#include "lard_pipeline.hpp"
+#include "lard_pipeline_compiler.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lard {
+
+    class LardPipelineRegistry;
+
+    // Counted reference to a registry pipeline, the pipeline is released with the last one.
+    class LardPipelineRef {
+    public:
+        LardPipelineRef() = default;
+        ~LardPipelineRef() { reset(); }
+        LardPipelineRef(const LardPipelineRef& other);
+        LardPipelineRef& operator=(const LardPipelineRef& other);
+        LardPipelineRef(LardPipelineRef&& other) noexcept;
+        LardPipelineRef& operator=(LardPipelineRef&& other) noexcept;
+
+        explicit operator bool() const { return registry != nullptr; }
+        // null while the pipeline is still compiling
+        LardPipeline* get() const { return pipeline ? pipeline->get() : nullptr; }
+        bool isReady() const { return get() != nullptr; }
+        void wait() const { pipeline->wait(); }
+        bool hasFailed() const { return pipeline && pipeline->hasFailed(); }
+        const std::string& getError() const { return pipeline->getError(); }
+        // the stable hash of the pipeline state this refers to
+        uint64_t getHash() const { return hash; }
+        void reset();
+
+    private:
+        friend class LardPipelineRegistry;
+        LardPipelineRef(LardPipelineRegistry* registry, std::string key, uint64_t hash, LardPipelineHandle pipeline)
+            : registry{ registry }, key{ std::move(key) }, hash{ hash }, pipeline{ std::move(pipeline) } {}
+
+        LardPipelineRegistry* registry = nullptr;
+        std::string key;
+        uint64_t hash = 0;
+        LardPipelineHandle pipeline;
+    };
+
+    // Hands out one pipeline per distinct pipeline state, however many render systems ask for it.
+    // The state key covers the shader stages, vertex layout, every fixed function state, the
+    // pipeline layout and the render target, and pipelines are built on the compiler's threads.
+    // Pipeline layouts are deduplicated the same way so identical render systems share them,
+    // which is what lets their pipelines match. Only use from the thread driving the frames.
+    class LardPipelineRegistry {
+    public:
+        struct Stats {
+            uint64_t hits = 0;
+            uint64_t misses = 0;
+            uint32_t pipelineCount = 0;  // pipelines with live references
+            uint32_t pipelineLayoutCount = 0;
+            uint32_t descriptorSetLayoutCount = 0;
+        };
+
+        LardPipelineRegistry(LardDevice& device, LardPipelineCompiler& compiler);
+        ~LardPipelineRegistry();
+        LardPipelineRegistry(const LardPipelineRegistry&) = delete;
+        LardPipelineRegistry& operator=(const LardPipelineRegistry&) = delete;
+
+        // owned by the registry and kept until it is destroyed, immutable samplers are not supported
+        VkDescriptorSetLayout getDescriptorSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+        // owned by the registry and kept until it is destroyed
+        VkPipelineLayout getPipelineLayout(
+            const std::vector<VkPushConstantRange>& pushConstantRanges,
+            const std::vector<VkDescriptorSetLayout>& setLayouts = {});
+
+        // the pipeline may still be compiling when this returns, wait() on the ref to block
+        LardPipelineRef acquire(
+            const std::string& vertShader,
+            const std::string& fragShader,
+            const PipelineConfigInfo& configInfo);
+
+        // FNV-1a of the state key, the same across runs as long as the pipeline layout came from
+        // getPipelineLayout
+        uint64_t hashState(
+            const std::string& vertShader,
+            const std::string& fragShader,
+            const PipelineConfigInfo& configInfo) const;
+
+        Stats getStats() const;
+        void printStats(std::ostream& out) const;
+
+    private:
+        friend class LardPipelineRef;
+
+        struct Entry {
+            LardPipelineHandle pipeline;
+            uint32_t refCount = 0;
+        };
+
+        struct KeyHash {
+            size_t operator()(const std::string& key) const { return static_cast<size_t>(hashKey(key)); }
+        };
+
+        std::string makeKey(
+            const std::string& vertShader,
+            const std::string& fragShader,
+            const PipelineConfigInfo& configInfo) const;
+        static uint64_t hashKey(const std::string& key);
+        void addRef(const std::string& key);
+        void release(const std::string& key);
+
+        LardDevice& lardDevice;
+        LardPipelineCompiler& compiler;
+        std::unordered_map<std::string, Entry, KeyHash> pipelines;
+        std::unordered_map<std::string, VkPipelineLayout, KeyHash> pipelineLayouts;
+        // what each of pipelineLayouts was created from, keys pipelines by layout contents
+        std::unordered_map<VkPipelineLayout, std::string> pipelineLayoutKeys;
+        std::unordered_map<std::string, VkDescriptorSetLayout, KeyHash> descriptorSetLayouts;
+        std::unordered_map<VkDescriptorSetLayout, std::string> descriptorSetLayoutKeys;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+}  // namespace lard
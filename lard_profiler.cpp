@@ -0,0 +1,153 @@
+#include "lard_profiler.hpp"
+
+// std headers
+#include <algorithm>
+#include <cassert>
+#include <iomanip>
+#include <stdexcept>
+
+namespace lard {
+
+    LardProfiler::LardProfiler(LardDevice& device, uint32_t frameCount) : lardDevice{ device } {
+        frames.resize(frameCount);
+        timestampPeriodMs = lardDevice.properties.limits.timestampPeriod / 1e6;
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(lardDevice.getPhysicalDevice(), &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(
+            lardDevice.getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+        uint32_t validBits = queueFamilies[lardDevice.findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+        if (validBits == 0 || timestampPeriodMs == 0.0) {
+            return;
+        }
+        timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = frameCount * MAX_SCOPES_PER_FRAME * 2;
+
+        if (vkCreateQueryPool(lardDevice.device(), &poolInfo, nullptr, &queryPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+        queryResults.resize(MAX_SCOPES_PER_FRAME * 2);
+    }
+
+    LardProfiler::~LardProfiler() {
+        if (queryPool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(lardDevice.device(), queryPool, nullptr);
+        }
+    }
+
+    void LardProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex) {
+        assert(frameIndex < frames.size() && "Frame index out of range");
+        if (!isSupported()) {
+            return;
+        }
+
+        readResults(frameIndex);
+        currentFrame = frameIndex;
+        frames[frameIndex].names.clear();
+        vkCmdResetQueryPool(
+            commandBuffer, queryPool, frameIndex * MAX_SCOPES_PER_FRAME * 2, MAX_SCOPES_PER_FRAME * 2);
+    }
+
+    uint32_t LardProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name) {
+        auto& frame = frames[currentFrame];
+        if (!isSupported() || frame.names.size() == MAX_SCOPES_PER_FRAME) {
+            return INVALID_SCOPE;
+        }
+
+        uint32_t scope = static_cast<uint32_t>(frame.names.size());
+        frame.names.push_back(name);
+        frame.pending = true;
+        vkCmdWriteTimestamp(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            queryPool,
+            (currentFrame * MAX_SCOPES_PER_FRAME + scope) * 2);
+        return scope;
+    }
+
+    void LardProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope) {
+        if (scope == INVALID_SCOPE) {
+            return;
+        }
+        vkCmdWriteTimestamp(
+            commandBuffer,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            queryPool,
+            (currentFrame * MAX_SCOPES_PER_FRAME + scope) * 2 + 1);
+    }
+
+    void LardProfiler::readResults(uint32_t frameIndex) {
+        auto& frame = frames[frameIndex];
+        if (!frame.pending) {
+            return;
+        }
+        frame.pending = false;
+
+        // the frame that wrote these has retired, VK_NOT_READY would mean a scope was never closed
+        uint32_t queryCount = static_cast<uint32_t>(frame.names.size()) * 2;
+        VkResult result = vkGetQueryPoolResults(
+            lardDevice.device(),
+            queryPool,
+            frameIndex * MAX_SCOPES_PER_FRAME * 2,
+            queryCount,
+            queryCount * sizeof(uint64_t),
+            queryResults.data(),
+            sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT);
+        if (result != VK_SUCCESS) {
+            return;
+        }
+
+        lastResults.clear();
+        for (size_t i = 0; i < frame.names.size(); i++) {
+            uint64_t ticks = (queryResults[i * 2 + 1] - queryResults[i * 2]) & timestampMask;
+            ScopeTiming timing{ frame.names[i], ticks * timestampPeriodMs };
+            lastResults.push_back(timing);
+
+            auto it = std::find_if(totals.begin(), totals.end(), [&](const ScopeTotal& total) {
+                return total.name == timing.name;
+            });
+            if (it == totals.end()) {
+                it = totals.insert(totals.end(), ScopeTotal{ timing.name });
+            }
+            it->totalMs += timing.ms;
+            it->count++;
+        }
+
+        framesSinceSummary++;
+        if (summaryInterval > 0 && framesSinceSummary >= summaryInterval) {
+            printSummary(*summaryOut);
+        }
+    }
+
+    std::vector<LardProfiler::ScopeTiming> LardProfiler::getAverages() const {
+        std::vector<ScopeTiming> averages;
+        for (const auto& total : totals) {
+            averages.push_back({ total.name, total.totalMs / total.count });
+        }
+        return averages;
+    }
+
+    void LardProfiler::printSummary(std::ostream& out) {
+        out << "gpu time over " << framesSinceSummary << " frames:" << std::endl;
+        for (const auto& timing : getAverages()) {
+            out << "\t" << std::setw(24) << std::left << timing.name << std::right
+                << std::fixed << std::setprecision(3) << timing.ms << " ms" << std::endl;
+        }
+        out << std::defaultfloat;
+        totals.clear();
+        framesSinceSummary = 0;
+    }
+
+    void LardProfiler::setSummaryInterval(uint32_t frameInterval, std::ostream& out) {
+        summaryInterval = frameInterval;
+        summaryOut = &out;
+    }
+
+}  // namespace lard
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "lard_device.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lard {
+
+    // GPU timestamps around named scopes of the frame command buffer. Each frame in flight owns a
+    // slice of one query pool; a slice is read back when its frame slot comes around again, at
+    // which point the frame has retired and vkGetQueryPoolResults never blocks.
+    class LardProfiler {
+    public:
+        static constexpr uint32_t MAX_SCOPES_PER_FRAME = 64;
+        static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+
+        struct ScopeTiming {
+            std::string name;
+            double ms = 0.0;
+        };
+
+        LardProfiler(LardDevice& device, uint32_t frameCount);
+        ~LardProfiler();
+        LardProfiler(const LardProfiler&) = delete;
+        LardProfiler& operator=(const LardProfiler&) = delete;
+
+        // false when the graphics queue cannot write timestamps, scopes are no-ops then
+        bool isSupported() const { return queryPool != VK_NULL_HANDLE; }
+
+        // Collects the previous results of frameIndex and resets its queries, call right after
+        // vkBeginCommandBuffer and outside of any render pass.
+        void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+        uint32_t beginScope(VkCommandBuffer commandBuffer, const char* name);
+        void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+        // scopes of the most recent frame with results, in the order they were opened
+        const std::vector<ScopeTiming>& getLastResults() const { return lastResults; }
+        // average per scope name since the last summary
+        std::vector<ScopeTiming> getAverages() const;
+        void printSummary(std::ostream& out);
+        // prints a summary every frameInterval frames with results, 0 turns it off
+        void setSummaryInterval(uint32_t frameInterval, std::ostream& out);
+
+    private:
+        struct FrameQueries {
+            std::vector<const char*> names;
+            bool pending = false;
+        };
+        struct ScopeTotal {
+            std::string name;
+            double totalMs = 0.0;
+            uint32_t count = 0;
+        };
+
+        void readResults(uint32_t frameIndex);
+
+        LardDevice& lardDevice;
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        double timestampPeriodMs;
+        uint64_t timestampMask;
+
+        std::vector<FrameQueries> frames;
+        uint32_t currentFrame = 0;
+        std::vector<uint64_t> queryResults;
+
+        std::vector<ScopeTiming> lastResults;
+        std::vector<ScopeTotal> totals;
+        uint32_t framesSinceSummary = 0;
+        uint32_t summaryInterval = 0;
+        std::ostream* summaryOut = nullptr;
+    };
+
+    // Times the commands recorded while it is alive.
+    class LardProfileScope {
+    public:
+        LardProfileScope(LardProfiler& profiler, VkCommandBuffer commandBuffer, const char* name)
+            : profiler{ profiler }, commandBuffer{ commandBuffer }, scope{ profiler.beginScope(commandBuffer, name) } {}
+        ~LardProfileScope() { profiler.endScope(commandBuffer, scope); }
+        LardProfileScope(const LardProfileScope&) = delete;
+        LardProfileScope& operator=(const LardProfileScope&) = delete;
+
+    private:
+        LardProfiler& profiler;
+        VkCommandBuffer commandBuffer;
+        uint32_t scope;
+    };
+
+}  // namespace lard
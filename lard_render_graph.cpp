@@ -0,0 +1,558 @@
+#include "lard_render_graph.hpp"
+#include "lard_profiler.hpp"
+
+// std headers
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace lard {
+
+    static bool sameDesc(const LardAttachmentDesc& a, const LardAttachmentDesc& b) {
+        return a.format == b.format && a.extent.width == b.extent.width && a.extent.height == b.extent.height &&
+            a.usage == b.usage && a.aspect == b.aspect && a.samples == b.samples;
+    }
+
+    LardRenderGraph::ResourceId LardRenderGraph::PassBuilder::createImage(const LardAttachmentDesc& desc) {
+        Resource resource{};
+        resource.desc = desc;
+        resource.format = desc.format;
+        resource.extent = desc.extent;
+        resource.aspect = desc.aspect;
+        graph.resources.push_back(resource);
+        return static_cast<ResourceId>(graph.resources.size() - 1);
+    }
+
+    void LardRenderGraph::PassBuilder::writeColor(ResourceId id) {
+        graph.addUse(passIndex, id, UseType::ColorAttachment, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+    }
+
+    void LardRenderGraph::PassBuilder::writeColor(ResourceId id, VkClearColorValue clear) {
+        auto& use = graph.addUse(passIndex, id, UseType::ColorAttachment, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT);
+        use.clear = true;
+        use.clearValue.color = clear;
+    }
+
+    void LardRenderGraph::PassBuilder::writeDepth(ResourceId id) {
+        graph.addUse(passIndex, id, UseType::DepthAttachment,
+            VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT);
+    }
+
+    void LardRenderGraph::PassBuilder::writeDepth(ResourceId id, VkClearDepthStencilValue clear) {
+        auto& use = graph.addUse(passIndex, id, UseType::DepthAttachment,
+            VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT);
+        use.clear = true;
+        use.clearValue.depthStencil = clear;
+    }
+
+    void LardRenderGraph::PassBuilder::readTexture(ResourceId id, VkPipelineStageFlags2KHR stages) {
+        graph.addUse(passIndex, id, UseType::Texture, stages);
+    }
+
+    void LardRenderGraph::PassBuilder::readWriteStorage(ResourceId id, VkPipelineStageFlags2KHR stages) {
+        graph.addUse(passIndex, id, UseType::Storage, stages);
+    }
+
+    void LardRenderGraph::PassBuilder::setSideEffects() {
+        graph.passes[passIndex].sideEffects = true;
+    }
+
+    void LardRenderGraph::PassBuilder::setSecondaryCommandBuffers() {
+        graph.passes[passIndex].secondary = true;
+    }
+
+    LardRenderGraph::LardRenderGraph(LardDevice& device) : lardDevice{ device } {}
+
+    LardRenderGraph::~LardRenderGraph() {
+        if (attachmentPool != nullptr) {
+            // the last frames executed may still use the transient images
+            lardDevice.deferDestroy([pool = attachmentPool]() mutable { pool.reset(); });
+        }
+    }
+
+    void LardRenderGraph::reset() {
+        resources.clear();
+        passes.clear();
+        groups.clear();
+        finalBarriers.clear();
+        stats = Stats{};
+        compiled = false;
+    }
+
+    LardRenderGraph::ResourceId LardRenderGraph::importImage(const LardImportedImage& image) {
+        assert(!compiled && "Cannot import into a compiled render graph, reset it first");
+        Resource resource{};
+        resource.imported = true;
+        resource.import = image;
+        resource.format = image.format;
+        resource.extent = image.extent;
+        resource.aspect = image.aspect;
+        resources.push_back(resource);
+        return static_cast<ResourceId>(resources.size() - 1);
+    }
+
+    void LardRenderGraph::addPass(const char* name, const SetupFn& setup, ExecuteFn execute) {
+        assert(!compiled && "Cannot add passes to a compiled render graph, reset it first");
+        Pass pass{};
+        pass.name = name;
+        pass.execute = std::move(execute);
+        passes.push_back(std::move(pass));
+
+        PassBuilder builder{ *this, static_cast<uint32_t>(passes.size() - 1) };
+        setup(builder);
+    }
+
+    LardRenderGraph::Use& LardRenderGraph::addUse(uint32_t passIndex, ResourceId id, UseType type, VkPipelineStageFlags2KHR stages) {
+        assert(id < resources.size() && "Unknown render graph resource");
+        Use use{};
+        use.id = id;
+        use.type = type;
+        use.stages = stages;
+        passes[passIndex].uses.push_back(use);
+        return passes[passIndex].uses.back();
+    }
+
+    void LardRenderGraph::compile() {
+        assert(!compiled && "Render graph is already compiled");
+        cullPasses();
+        allocateTransients();
+        buildGroups();
+        recordBarriers();
+        compiled = true;
+    }
+
+    void LardRenderGraph::cullPasses() {
+        // walk back from the outputs, a pass lives if a live pass or the outside reads what it writes
+        std::vector<bool> needed(resources.size(), false);
+        for (size_t id = 0; id < resources.size(); id++) {
+            needed[id] = resources[id].imported && resources[id].import.output;
+        }
+
+        for (size_t i = passes.size(); i-- > 0;) {
+            auto& pass = passes[i];
+            pass.live = pass.sideEffects || std::any_of(pass.uses.begin(), pass.uses.end(),
+                [&](const Use& use) { return use.type != UseType::Texture && needed[use.id]; });
+            if (!pass.live) {
+                stats.culledPassCount++;
+                continue;
+            }
+            // a cleared attachment does not depend on whoever wrote it before
+            for (const auto& use : pass.uses) {
+                if (use.clear) {
+                    needed[use.id] = false;
+                }
+            }
+            for (const auto& use : pass.uses) {
+                if (!use.clear) {
+                    needed[use.id] = true;
+                }
+            }
+        }
+        stats.passCount = static_cast<uint32_t>(passes.size());
+    }
+
+    void LardRenderGraph::allocateTransients() {
+        for (uint32_t i = 0; i < passes.size(); i++) {
+            if (!passes[i].live) {
+                continue;
+            }
+            for (const auto& use : passes[i].uses) {
+                auto& resource = resources[use.id];
+                resource.firstPass = std::min(resource.firstPass, i);
+                resource.lastPass = std::max(resource.lastPass, i);
+                switch (use.type) {
+                case UseType::ColorAttachment: resource.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; break;
+                case UseType::DepthAttachment: resource.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT; break;
+                case UseType::Texture: resource.usage |= VK_IMAGE_USAGE_SAMPLED_BIT; break;
+                case UseType::Storage: resource.usage |= VK_IMAGE_USAGE_STORAGE_BIT; break;
+                }
+            }
+        }
+
+        std::vector<LardAttachmentDesc> descs;
+        std::vector<std::pair<uint32_t, uint32_t>> lifetimes;
+        for (auto& resource : resources) {
+            if (resource.imported || resource.firstPass == UINT32_MAX) {
+                continue;
+            }
+            auto desc = resource.desc;
+            desc.usage |= resource.usage;
+            resource.handle = static_cast<LardAttachmentPool::Handle>(descs.size());
+            descs.push_back(desc);
+            lifetimes.emplace_back(resource.firstPass, resource.lastPass);
+        }
+
+        bool unchanged = attachmentPool != nullptr && lifetimes == poolLifetimes &&
+            std::equal(descs.begin(), descs.end(), poolDescs.begin(), poolDescs.end(), sameDesc);
+        if (unchanged) {
+            return;
+        }
+
+        if (attachmentPool != nullptr) {
+            // frames still in flight render to the old images
+            lardDevice.deferDestroy([pool = attachmentPool]() mutable { pool.reset(); });
+        }
+        attachmentPool = std::make_shared<LardAttachmentPool>(lardDevice);
+        for (size_t i = 0; i < descs.size(); i++) {
+            attachmentPool->request(descs[i], lifetimes[i].first, lifetimes[i].second);
+        }
+        attachmentPool->build();
+        memoryRangeStates.assign(attachmentPool->memoryRangeCount(), ResourceState{});
+        poolDescs = std::move(descs);
+        poolLifetimes = std::move(lifetimes);
+    }
+
+    bool LardRenderGraph::canMerge(const Group& group, const Pass& pass) const {
+        // a rendering instance has either inline or secondary contents
+        if (pass.secondary != group.secondary) {
+            return false;
+        }
+        std::vector<ResourceId> colors;
+        ResourceId depth = INVALID_RESOURCE;
+        for (const auto& use : pass.uses) {
+            if (use.clear) {
+                return false;
+            }
+            if (use.type == UseType::ColorAttachment) {
+                colors.push_back(use.id);
+            } else if (use.type == UseType::DepthAttachment) {
+                depth = use.id;
+            } else if (use.type == UseType::Storage) {
+                return false;
+            } else {
+                // sampled reads are hoisted in front of the group, so nothing in it may write them
+                for (uint32_t other : group.passes) {
+                    for (const auto& otherUse : passes[other].uses) {
+                        if (otherUse.id == use.id && otherUse.type != UseType::Texture) {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (colors.size() != group.colorAttachments.size() || (depth != INVALID_RESOURCE) != group.hasDepth ||
+            (group.hasDepth && depth != group.depthAttachment.id)) {
+            return false;
+        }
+        for (size_t i = 0; i < colors.size(); i++) {
+            if (colors[i] != group.colorAttachments[i].id) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void LardRenderGraph::buildGroups() {
+        for (uint32_t i = 0; i < passes.size(); i++) {
+            const auto& pass = passes[i];
+            if (!pass.live) {
+                continue;
+            }
+            bool rendering = std::any_of(pass.uses.begin(), pass.uses.end(), isAttachment);
+            if (rendering && !groups.empty() && groups.back().rendering && canMerge(groups.back(), pass)) {
+                groups.back().passes.push_back(i);
+                continue;
+            }
+
+            Group group{};
+            group.passes.push_back(i);
+            group.rendering = rendering;
+            group.secondary = pass.secondary;
+            for (const auto& use : pass.uses) {
+                Attachment attachment{ use.id, VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE, use.clearValue };
+                if (use.type == UseType::ColorAttachment) {
+                    group.colorAttachments.push_back(attachment);
+                    group.extent = resources[use.id].extent;
+                } else if (use.type == UseType::DepthAttachment) {
+                    group.hasDepth = true;
+                    group.depthAttachment = attachment;
+                    group.extent = resources[use.id].extent;
+                }
+            }
+            groups.push_back(std::move(group));
+        }
+
+        bool rendering = std::any_of(groups.begin(), groups.end(), [](const Group& group) { return group.rendering; });
+        if (rendering && !lardDevice.hasDynamicRendering()) {
+            throw std::runtime_error("render graph passes need VK_KHR_dynamic_rendering!");
+        }
+        stats.groupCount = static_cast<uint32_t>(groups.size());
+    }
+
+    bool LardRenderGraph::isReadAfter(ResourceId id, size_t groupIndex) const {
+        for (size_t i = groupIndex + 1; i < groups.size(); i++) {
+            for (uint32_t passIndex : groups[i].passes) {
+                for (const auto& use : passes[passIndex].uses) {
+                    if (use.id == id) {
+                        // the first later use decides, a clear starts over
+                        return !use.clear;
+                    }
+                }
+            }
+        }
+        const auto& resource = resources[id];
+        return resource.imported && resource.import.output;
+    }
+
+    void LardRenderGraph::recordBarriers() {
+        for (auto& resource : resources) {
+            if (resource.imported) {
+                resource.state.layout = resource.import.initialLayout;
+                resource.state.writeStages = resource.import.initialStages;
+                resource.state.writeAccess = resource.import.initialAccess;
+                resource.written = resource.import.initialLayout != VK_IMAGE_LAYOUT_UNDEFINED;
+            }
+        }
+
+        for (size_t groupIndex = 0; groupIndex < groups.size(); groupIndex++) {
+            auto& group = groups[groupIndex];
+
+            // one access per image for the whole group, merged passes share the attachments
+            std::vector<Use> groupUses;
+            for (uint32_t passIndex : group.passes) {
+                for (const auto& use : passes[passIndex].uses) {
+                    auto existing = std::find_if(groupUses.begin(), groupUses.end(),
+                        [&](const Use& other) { return other.id == use.id; });
+                    if (existing == groupUses.end()) {
+                        groupUses.push_back(use);
+                    } else {
+                        existing->stages |= use.stages;
+                    }
+                }
+            }
+
+            auto setOps = [&](Attachment& attachment) {
+                const auto& use = *std::find_if(groupUses.begin(), groupUses.end(),
+                    [&](const Use& other) { return other.id == attachment.id; });
+                if (use.clear) {
+                    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+                } else {
+                    attachment.loadOp = resources[attachment.id].written ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+                }
+                attachment.storeOp = isReadAfter(attachment.id, groupIndex) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            };
+            for (auto& attachment : group.colorAttachments) {
+                setOps(attachment);
+            }
+            if (group.hasDepth) {
+                setOps(group.depthAttachment);
+            }
+
+            for (const auto& use : groupUses) {
+                transition(use.id, use, group.barriers);
+            }
+        }
+
+        for (ResourceId id = 0; id < resources.size(); id++) {
+            auto& resource = resources[id];
+            if (!resource.imported || resource.import.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED ||
+                resource.import.finalLayout == resource.state.layout) {
+                continue;
+            }
+            VkImageMemoryBarrier2KHR barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+            barrier.srcStageMask = resource.state.writeStages | resource.state.readStages;
+            barrier.srcAccessMask = resource.state.writeAccess;
+            // whatever consumes the image (present, a readback) synchronizes on its own
+            barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+            barrier.dstAccessMask = VK_ACCESS_2_NONE;
+            barrier.oldLayout = resource.written ? resource.state.layout : VK_IMAGE_LAYOUT_UNDEFINED;
+            barrier.newLayout = resource.import.finalLayout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = resource.import.image;
+            barrier.subresourceRange = { resource.aspect, 0, 1, 0, 1 };
+            finalBarriers.push_back(barrier);
+            stats.barrierCount++;
+        }
+    }
+
+    void LardRenderGraph::transition(ResourceId id, const Use& use, std::vector<VkImageMemoryBarrier2KHR>& barriers) {
+        auto& resource = resources[id];
+
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkAccessFlags2KHR access = VK_ACCESS_2_NONE;
+        bool write = true;
+        switch (use.type) {
+        case UseType::ColorAttachment:
+            layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            access = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | (use.clear ? VK_ACCESS_2_NONE : VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT);
+            break;
+        case UseType::DepthAttachment:
+            layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+            break;
+        case UseType::Texture:
+            layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+            write = false;
+            break;
+        case UseType::Storage:
+            layout = VK_IMAGE_LAYOUT_GENERAL;
+            access = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+            break;
+        }
+
+        // a transient image's memory was last used by whatever aliases it, possibly last frame,
+        // and its own layout is lost with that
+        bool fresh = !resource.imported && resource.state.layout == VK_IMAGE_LAYOUT_UNDEFINED && !resource.written;
+        auto& state = resource.state;
+        if (fresh) {
+            state = memoryRangeStates[attachmentPool->getMemoryRange(resource.handle)];
+        }
+        bool discard = !resource.written || use.clear;
+        bool layoutChange = fresh || state.layout != layout;
+
+        VkImageMemoryBarrier2KHR barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+        barrier.dstStageMask = use.stages;
+        barrier.dstAccessMask = access;
+        barrier.oldLayout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+        barrier.newLayout = layout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = getImage(id);
+        barrier.subresourceRange = { resource.aspect, 0, 1, 0, 1 };
+
+        if (!write && !layoutChange) {
+            // read after read in the same layout, only the last write has to be made visible
+            if (state.writeStages != VK_PIPELINE_STAGE_2_NONE && (use.stages & ~state.visibleStages) != 0) {
+                barrier.srcStageMask = state.writeStages;
+                barrier.srcAccessMask = state.writeAccess;
+                barriers.push_back(barrier);
+                stats.barrierCount++;
+            }
+            state.readStages |= use.stages;
+            state.visibleStages |= use.stages;
+        } else {
+            // reads before a write only need an execution dependency
+            barrier.srcStageMask = state.writeStages | state.readStages;
+            barrier.srcAccessMask = state.writeAccess;
+            if (layoutChange || barrier.srcStageMask != VK_PIPELINE_STAGE_2_NONE) {
+                barriers.push_back(barrier);
+                stats.barrierCount++;
+            }
+            // a layout transition is a write the next accesses have to wait for
+            state.layout = layout;
+            state.writeStages = use.stages;
+            state.writeAccess = write ? access : VK_ACCESS_2_NONE;
+            state.readStages = write ? VK_PIPELINE_STAGE_2_NONE : use.stages;
+            state.visibleStages = use.stages;
+        }
+
+        if (write) {
+            resource.written = true;
+        }
+        if (!resource.imported) {
+            memoryRangeStates[attachmentPool->getMemoryRange(resource.handle)] = state;
+        }
+    }
+
+    void LardRenderGraph::execute(VkCommandBuffer commandBuffer, LardProfiler* profiler) {
+        assert(compiled && "Render graph must be compiled before it is executed");
+
+        auto barrier = [&](const std::vector<VkImageMemoryBarrier2KHR>& barriers) {
+            if (barriers.empty()) {
+                return;
+            }
+            VkDependencyInfoKHR dependencyInfo{};
+            dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+            dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(barriers.size());
+            dependencyInfo.pImageMemoryBarriers = barriers.data();
+            lardDevice.cmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+        };
+
+        for (const auto& group : groups) {
+            barrier(group.barriers);
+
+            uint32_t scope = LardProfiler::INVALID_SCOPE;
+            if (profiler != nullptr) {
+                scope = profiler->beginScope(commandBuffer, passes[group.passes.front()].name);
+            }
+
+            if (group.rendering) {
+                auto attachmentInfo = [&](const Attachment& attachment, VkImageLayout layout) {
+                    VkRenderingAttachmentInfoKHR info{};
+                    info.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+                    info.imageView = getView(attachment.id);
+                    info.imageLayout = layout;
+                    info.loadOp = attachment.loadOp;
+                    info.storeOp = attachment.storeOp;
+                    info.clearValue = attachment.clearValue;
+                    return info;
+                };
+                std::vector<VkRenderingAttachmentInfoKHR> colorAttachments;
+                for (const auto& attachment : group.colorAttachments) {
+                    colorAttachments.push_back(attachmentInfo(attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+                }
+                VkRenderingAttachmentInfoKHR depthAttachment{};
+                if (group.hasDepth) {
+                    depthAttachment = attachmentInfo(group.depthAttachment, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+                }
+
+                VkRenderingInfoKHR renderingInfo{};
+                renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+                renderingInfo.renderArea.offset = { 0, 0 };
+                renderingInfo.renderArea.extent = group.extent;
+                renderingInfo.layerCount = 1;
+                renderingInfo.colorAttachmentCount = static_cast<uint32_t>(colorAttachments.size());
+                renderingInfo.pColorAttachments = colorAttachments.data();
+                renderingInfo.pDepthAttachment = group.hasDepth ? &depthAttachment : nullptr;
+                if (group.secondary) {
+                    renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+                }
+                lardDevice.cmdBeginRendering(commandBuffer, &renderingInfo);
+
+                currentInheritance = LardSecondaryInheritance{};
+                currentInheritance.colorFormat = group.colorAttachments.empty() ? VK_FORMAT_UNDEFINED : resources[group.colorAttachments.front().id].format;
+                currentInheritance.depthFormat = group.hasDepth ? resources[group.depthAttachment.id].format : VK_FORMAT_UNDEFINED;
+                currentInheritance.extent = group.extent;
+
+                // secondary buffers set their own, nothing but vkCmdExecuteCommands is allowed then
+                if (!group.secondary) {
+                    VkViewport viewport{};
+                    viewport.x = 0.0f;
+                    viewport.y = 0.0f;
+                    viewport.width = static_cast<float>(group.extent.width);
+                    viewport.height = static_cast<float>(group.extent.height);
+                    viewport.minDepth = 0.0f;
+                    viewport.maxDepth = 1.0f;
+                    VkRect2D scissor{ {0, 0}, group.extent };
+                    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+                    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+                }
+            }
+
+            for (uint32_t passIndex : group.passes) {
+                passes[passIndex].execute(commandBuffer, *this);
+            }
+
+            if (group.rendering) {
+                lardDevice.cmdEndRendering(commandBuffer);
+            }
+            if (profiler != nullptr) {
+                profiler->endScope(commandBuffer, scope);
+            }
+        }
+
+        barrier(finalBarriers);
+    }
+
+    VkImage LardRenderGraph::getImage(ResourceId id) const {
+        const auto& resource = resources[id];
+        if (resource.imported) {
+            return resource.import.image;
+        }
+        return resource.firstPass == UINT32_MAX ? VK_NULL_HANDLE : attachmentPool->getImage(resource.handle);
+    }
+
+    VkImageView LardRenderGraph::getView(ResourceId id) const {
+        const auto& resource = resources[id];
+        if (resource.imported) {
+            return resource.import.view;
+        }
+        return resource.firstPass == UINT32_MAX ? VK_NULL_HANDLE : attachmentPool->getView(resource.handle);
+    }
+
+}  // namespace lard
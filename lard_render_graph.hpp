@@ -0,0 +1,202 @@
+#pragma once
+
+#include "lard_attachment_pool.hpp"
+#include "lard_command_recorder.hpp"
+#include "lard_device.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace lard {
+
+    class LardProfiler;
+
+    // An image owned outside the graph, e.g. the swap chain image. The initial state must cover
+    // whatever touched the image before the graph runs, the graph waits on those stages.
+    struct LardImportedImage {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkExtent2D extent{};
+        VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+
+        VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags2KHR initialStages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2KHR initialAccess = VK_ACCESS_2_NONE;
+        // left in this layout after the last pass, UNDEFINED keeps whatever the last pass used
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        // the contents are consumed after the graph, passes writing it are never culled
+        bool output = false;
+    };
+
+    // Per-frame graph of passes and the images they read and write. Rebuilt every frame:
+    // reset(), import and add passes, compile(), execute(). Compiling
+    //  - culls passes whose results nothing reads,
+    //  - merges consecutive passes drawing to the same attachments into one dynamic rendering
+    //    instance when the later one neither clears nor reads anything written in between,
+    //  - places transient images in an attachment pool, aliased by lifetime, and keeps that pool
+    //    for as long as the set of transient images stays the same,
+    //  - records the smallest set of synchronization2 barriers between the remaining passes:
+    //    reads after reads in the same layout need none.
+    //
+    // Graphics passes render with VK_KHR_dynamic_rendering, the graph cannot run without it.
+    // Pass names must outlive the frame (string literals), the profiler keeps them.
+    class LardRenderGraph {
+    public:
+        using ResourceId = uint32_t;
+        static constexpr ResourceId INVALID_RESOURCE = UINT32_MAX;
+
+        struct Stats {
+            uint32_t passCount = 0;
+            uint32_t culledPassCount = 0;
+            uint32_t groupCount = 0;  // rendering instances and non-rendering passes after merging
+            uint32_t barrierCount = 0;
+        };
+
+        class PassBuilder {
+        public:
+            ResourceId createImage(const LardAttachmentDesc& desc);
+            // without a clear value the previous contents are loaded
+            void writeColor(ResourceId id);
+            void writeColor(ResourceId id, VkClearColorValue clear);
+            void writeDepth(ResourceId id);
+            void writeDepth(ResourceId id, VkClearDepthStencilValue clear);
+            void readTexture(ResourceId id, VkPipelineStageFlags2KHR stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT);
+            void readWriteStorage(ResourceId id, VkPipelineStageFlags2KHR stages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+            // work with effects outside the graph, never culled
+            void setSideEffects();
+            // the pass only calls vkCmdExecuteCommands, with secondary buffers inheriting
+            // getSecondaryInheritance(); it is only merged with passes doing the same
+            void setSecondaryCommandBuffers();
+
+        private:
+            friend class LardRenderGraph;
+            PassBuilder(LardRenderGraph& graph, uint32_t passIndex) : graph{ graph }, passIndex{ passIndex } {}
+
+            LardRenderGraph& graph;
+            uint32_t passIndex;
+        };
+
+        using SetupFn = std::function<void(PassBuilder&)>;
+        using ExecuteFn = std::function<void(VkCommandBuffer, const LardRenderGraph&)>;
+
+        explicit LardRenderGraph(LardDevice& device);
+        ~LardRenderGraph();
+        LardRenderGraph(const LardRenderGraph&) = delete;
+        LardRenderGraph& operator=(const LardRenderGraph&) = delete;
+
+        void reset();
+        ResourceId importImage(const LardImportedImage& image);
+        void addPass(const char* name, const SetupFn& setup, ExecuteFn execute);
+        void compile();
+        // one profiler scope per rendering instance or non-rendering pass when profiler is set
+        void execute(VkCommandBuffer commandBuffer, LardProfiler* profiler = nullptr);
+
+        // valid from compile() on, for descriptor writes in execute callbacks
+        VkImage getImage(ResourceId id) const;
+        VkImageView getView(ResourceId id) const;
+        VkFormat getFormat(ResourceId id) const { return resources[id].format; }
+        VkExtent2D getExtent(ResourceId id) const { return resources[id].extent; }
+        // the rendering instance of the pass being executed
+        const LardSecondaryInheritance& getSecondaryInheritance() const { return currentInheritance; }
+
+        const Stats& getStats() const { return stats; }
+
+    private:
+        enum class UseType { ColorAttachment, DepthAttachment, Texture, Storage };
+
+        struct Use {
+            ResourceId id;
+            UseType type;
+            VkPipelineStageFlags2KHR stages;
+            bool clear = false;
+            VkClearValue clearValue{};
+        };
+
+        // what the last accesses to an image were, to derive the next barrier from
+        struct ResourceState {
+            VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            VkPipelineStageFlags2KHR writeStages = VK_PIPELINE_STAGE_2_NONE;
+            VkAccessFlags2KHR writeAccess = VK_ACCESS_2_NONE;
+            VkPipelineStageFlags2KHR readStages = VK_PIPELINE_STAGE_2_NONE;
+            // stages that already saw the last write
+            VkPipelineStageFlags2KHR visibleStages = VK_PIPELINE_STAGE_2_NONE;
+        };
+
+        struct Resource {
+            bool imported = false;
+            LardImportedImage import;
+            LardAttachmentDesc desc;
+            VkFormat format = VK_FORMAT_UNDEFINED;
+            VkExtent2D extent{};
+            VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+            VkImageUsageFlags usage = 0;
+
+            // compile state
+            uint32_t firstPass = UINT32_MAX;
+            uint32_t lastPass = 0;
+            LardAttachmentPool::Handle handle = 0;
+            ResourceState state;
+            bool written = false;  // contents defined in this frame or by the import
+        };
+
+        struct Pass {
+            const char* name;
+            std::vector<Use> uses;
+            ExecuteFn execute;
+            bool sideEffects = false;
+            bool secondary = false;
+            bool live = false;
+        };
+
+        struct Attachment {
+            ResourceId id;
+            VkAttachmentLoadOp loadOp;
+            VkAttachmentStoreOp storeOp;
+            VkClearValue clearValue;
+        };
+
+        struct Group {
+            std::vector<uint32_t> passes;
+            std::vector<VkImageMemoryBarrier2KHR> barriers;
+            bool rendering = false;
+            bool secondary = false;
+            std::vector<Attachment> colorAttachments;
+            bool hasDepth = false;
+            Attachment depthAttachment{};
+            VkExtent2D extent{};
+        };
+
+        static bool isAttachment(const Use& use) {
+            return use.type == UseType::ColorAttachment || use.type == UseType::DepthAttachment;
+        }
+        Use& addUse(uint32_t passIndex, ResourceId id, UseType type, VkPipelineStageFlags2KHR stages);
+        void cullPasses();
+        void allocateTransients();
+        void buildGroups();
+        bool canMerge(const Group& group, const Pass& pass) const;
+        void recordBarriers();
+        void transition(ResourceId id, const Use& use, std::vector<VkImageMemoryBarrier2KHR>& barriers);
+        bool isReadAfter(ResourceId id, size_t groupIndex) const;
+
+        LardDevice& lardDevice;
+        std::vector<Resource> resources;
+        std::vector<Pass> passes;
+        std::vector<Group> groups;
+        std::vector<VkImageMemoryBarrier2KHR> finalBarriers;
+        LardSecondaryInheritance currentInheritance;
+        bool compiled = false;
+
+        // transient images and the state their memory was left in, kept across frames
+        std::shared_ptr<LardAttachmentPool> attachmentPool;
+        std::vector<LardAttachmentDesc> poolDescs;
+        std::vector<std::pair<uint32_t, uint32_t>> poolLifetimes;
+        std::vector<ResourceState> memoryRangeStates;
+
+        Stats stats;
+    };
+
+}  // namespace lard
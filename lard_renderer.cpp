@@ -1,5 +1,7 @@
 #include "lard_renderer.hpp"
+#include "lard_uploader.hpp"
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <stdexcept>
@@ -7,7 +9,11 @@
 
 namespace lard {
 
-    LardRenderer::LardRenderer(LardWindow& window, LardDevice& device) : lardWindow{ window }, lardDevice{ device } {
+    LardRenderer::LardRenderer(LardWindow* window, LardDevice& device, VkExtent2D extent, LardFrameProfile profile)
+        : lardWindow{ window }, headlessExtent{ extent }, lardDevice{ device },
+        frameAllocator{ device, LardSwapChain::MAX_FRAMES_IN_FLIGHT }, renderGraph{ device },
+        profiler{ device, LardSwapChain::MAX_FRAMES_IN_FLIGHT },
+        commandRecorder{ device, LardSwapChain::MAX_FRAMES_IN_FLIGHT }, frameProfile{ profile } {
         recreateSwapChain();
         createCommandBuffers();
     }
@@ -16,23 +22,55 @@ namespace lard {
         freeCommandBuffers();
     }
 
-    void LardRenderer::recreateSwapChain() {
-        auto extent = lardWindow.getExtent();
-        while (extent.width == 0 || extent.height == 0) {
-            extent = lardWindow.getExtent();
-            glfwWaitEvents();
+    bool LardRenderer::recreateSwapChain() {
+        auto extent = headlessExtent;
+        if (lardWindow != nullptr) {
+            extent = lardWindow->getExtent();
+            if (extent.width == 0 || extent.height == 0) {
+                // minimized, nothing can be presented until the window comes back
+                return false;
+            }
         }
 
-        vkDeviceWaitIdle(lardDevice.device());
-
         if (lardSwapChain == nullptr) {
-            lardSwapChain = std::make_unique<LardSwapChain>(lardDevice, extent);
+            lardSwapChain = std::make_unique<LardSwapChain>(lardDevice, extent, frameProfile);
         } else {
             std::shared_ptr<LardSwapChain> oldSwapChain = std::move(lardSwapChain);
-            lardSwapChain = std::make_unique<LardSwapChain>(lardDevice, extent, oldSwapChain);
+            lardSwapChain = std::make_unique<LardSwapChain>(lardDevice, extent, frameProfile, oldSwapChain);
             if (!oldSwapChain->compareSwapFormats(*lardSwapChain.get())) {
                 throw std::runtime_error("Swap chain image or depth format has changed");
             }
+            // frames recorded against the old swap chain may still be in flight, no device idle:
+            // it is retired through oldSwapchain and destroyed once the current frame completes
+            lardDevice.deferDestroy([oldSwapChain]() mutable { oldSwapChain.reset(); });
+        }
+        swapChainDirty = false;
+        recreatedAtFrame = lardDevice.currentFrame();
+        return true;
+    }
+
+    void LardRenderer::setFrameProfile(LardFrameProfile profile) {
+        assert(!isFrameStarted && "Can't change the frame profile while a frame is in progress");
+        if (profile == frameProfile) {
+            return;
+        }
+        frameProfile = profile;
+        // frame slots are laid out differently under the new frame count, let them all drain
+        lardDevice.waitForFrame(lardDevice.currentFrame());
+        recreateSwapChain();
+        // frames of the two profiles are not comparable
+        pendingLatency.clear();
+        resetLatencyStats();
+    }
+
+    void LardRenderer::collectLatency() {
+        auto now = std::chrono::steady_clock::now();
+        while (!pendingLatency.empty() && lardDevice.isFrameComplete(pendingLatency.front().first)) {
+            double ms = std::chrono::duration<double, std::milli>(now - pendingLatency.front().second).count();
+            pendingLatency.pop_front();
+
+            latencyStats.averageMs += (ms - latencyStats.averageMs) / ++latencyStats.frameCount;
+            latencyStats.maxMs = std::max(latencyStats.maxMs, ms);
         }
     }
 
@@ -57,9 +95,21 @@ namespace lard {
 
     VkCommandBuffer LardRenderer::beginFrame() {
         assert(!isFrameStarted && "Can't call beginFrame while already in progress");
+        auto inputTime = std::chrono::steady_clock::now();
+
+        // everything staged since the last frame goes to the GPU in one submission
+        lardDevice.uploader().flush();
+
+        // a burst of resize events is coalesced into at most one recreation per presented frame,
+        // until then a suboptimal swap chain keeps being used
+        if (swapChainDirty && lardDevice.currentFrame() > recreatedAtFrame && !recreateSwapChain()) {
+            return nullptr;
+        }
 
         auto result = lardSwapChain->acquireNextImage(&currentImageIndex);
         if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            // cannot render to this one at all
+            swapChainDirty = true;
             recreateSwapChain();
             return nullptr;
         }
@@ -67,6 +117,14 @@ namespace lard {
             throw std::runtime_error("Failed to acquire swap chain image!");
         }
         isFrameStarted = true;
+        // acquireNextImage waited for the frame that used this slot before, so its transient
+        // data can be overwritten; retired deferred deletions run here as well
+        lardDevice.beginFrame();
+        currentFrameIndex = static_cast<int>(lardDevice.currentFrame() % lardSwapChain->framesInFlight());
+        collectLatency();
+        pendingLatency.emplace_back(lardDevice.currentFrame(), inputTime);
+        frameAllocator.beginFrame(currentFrameIndex);
+        commandRecorder.beginFrame(currentFrameIndex);
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -74,6 +132,9 @@ namespace lard {
         if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
             throw std::runtime_error("Failed to begin recording command buffer!");
         }
+        profiler.beginFrame(commandBuffer, currentFrameIndex);
+        frameScope = profiler.beginScope(commandBuffer, "frame");
+        importSwapChainImages();
 
         return commandBuffer;
     }
@@ -82,40 +143,100 @@ namespace lard {
         assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
 
         auto commandBuffer = getCurrentCommandBuffer();
+        profiler.endScope(commandBuffer, frameScope);
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             throw std::runtime_error("Failed to record command buffer!");
         }
         auto result = lardSwapChain->submitCommandBuffers(&commandBuffer, &currentImageIndex);
-        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || lardWindow.wasWindowResized()) {
-            lardWindow.resetWindowResizedFlag();
-            recreateSwapChain();
+        bool resized = lardWindow != nullptr && lardWindow->wasWindowResized();
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || resized) {
+            if (resized) {
+                lardWindow->resetWindowResizedFlag();
+            }
+            swapChainDirty = true;
         } else if (result != VK_SUCCESS) {
             throw std::runtime_error("Failed to present swap chain image!");
         }
 
         isFrameStarted = false;
-        currentFrameIndex = (currentFrameIndex + 1) % LardSwapChain::MAX_FRAMES_IN_FLIGHT;
+        collectLatency();
     }
 
-    void LardRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
-        assert(isFrameStarted && "Can't call beginSwapChainRenderPass while frame is not in progress");
-        assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on commanf buffer fromm a different frame");
+    void LardRenderer::importSwapChainImages() {
+        renderGraph.reset();
+
+        LardImportedImage color{};
+        color.image = lardSwapChain->getImage(currentImageIndex);
+        color.view = lardSwapChain->getImageView(currentImageIndex);
+        color.format = lardSwapChain->getSwapChainImageFormat();
+        color.extent = lardSwapChain->getSwapChainExtent();
+        color.aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+        // the acquire semaphore is waited on at color attachment output
+        color.initialStages = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT;
+        color.finalLayout = lardDevice.isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        color.output = true;
+        swapChainColor = renderGraph.importImage(color);
+
+        LardImportedImage depth{};
+        depth.image = lardSwapChain->getDepthImage(currentFrameIndex);
+        depth.view = lardSwapChain->getDepthImageView(currentFrameIndex);
+        depth.format = lardSwapChain->getSwapChainDepthFormat();
+        depth.extent = lardSwapChain->getSwapChainExtent();
+        depth.aspect = lardSwapChain->getSwapChainDepthAspect();
+        // written by the frame that last used this slot
+        depth.initialStages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT;
+        depth.initialAccess = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        swapChainDepth = renderGraph.importImage(depth);
+    }
+
+    void LardRenderer::executeRenderGraph(VkCommandBuffer commandBuffer) {
+        assert(isFrameStarted && "Can't execute the render graph while frame is not in progress");
+        assert(commandBuffer == getCurrentCommandBuffer() && "Can't execute the render graph on command buffer from a different frame");
+        renderGraph.compile();
+        renderGraph.execute(commandBuffer, &profiler);
+    }
 
-        VkRenderPassBeginInfo renderPassInfo{};
-        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        renderPassInfo.renderPass = lardSwapChain->getRenderPass();
-        renderPassInfo.framebuffer = lardSwapChain->getFrameBuffer(currentImageIndex);
+    LardSecondaryInheritance LardRenderer::getSwapChainInheritance() const {
+        assert(isFrameStarted && "Cannot get swap chain inheritance when frame not in progress");
+        LardSecondaryInheritance inheritance{};
+        inheritance.renderPass = lardSwapChain->getRenderPass();
+        if (inheritance.renderPass != VK_NULL_HANDLE) {
+            inheritance.framebuffer = lardSwapChain->getFrameBuffer(currentImageIndex, currentFrameIndex);
+        }
+        inheritance.colorFormat = lardSwapChain->getSwapChainImageFormat();
+        inheritance.depthFormat = lardSwapChain->getSwapChainDepthFormat();
+        inheritance.extent = lardSwapChain->getSwapChainExtent();
+        return inheritance;
+    }
 
-        renderPassInfo.renderArea.offset = { 0, 0 };
-        renderPassInfo.renderArea.extent = lardSwapChain->getSwapChainExtent();
+    void LardRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
+        assert(isFrameStarted && "Can't call beginSwapChainRenderPass while frame is not in progress");
+        assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on commanf buffer fromm a different frame");
 
         std::array<VkClearValue, 2> clearValues{};
-        clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f };
+        clearValues[0].color = getClearColor();
         clearValues[1].depthStencil = { 1.0f, 0 };
-        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-        renderPassInfo.pClearValues = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        renderPassScope = profiler.beginScope(commandBuffer, "swap chain render pass");
+        if (lardSwapChain->usesDynamicRendering()) {
+            beginSwapChainRendering(commandBuffer, clearValues[0], clearValues[1], contents);
+        } else {
+            VkRenderPassBeginInfo renderPassInfo{};
+            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            renderPassInfo.renderPass = lardSwapChain->getRenderPass();
+            renderPassInfo.framebuffer = lardSwapChain->getFrameBuffer(currentImageIndex, currentFrameIndex);
+
+            renderPassInfo.renderArea.offset = { 0, 0 };
+            renderPassInfo.renderArea.extent = lardSwapChain->getSwapChainExtent();
+            renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+            renderPassInfo.pClearValues = clearValues.data();
+
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+        }
+        if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) {
+            // the secondary buffers set viewport and scissor themselves
+            return;
+        }
 
         VkViewport viewport{};
         viewport.x = 0.0f;
@@ -133,7 +254,101 @@ namespace lard {
         assert(isFrameStarted && "Can't call endSwapChainRenderPass while frame is not in progress");
         assert(commandBuffer == getCurrentCommandBuffer() && "Can't end render pass on commanf buffer fromm a different frame");
 
+        if (lardSwapChain->usesDynamicRendering()) {
+            endSwapChainRendering(commandBuffer);
+        } else {
+            vkCmdEndRenderPass(commandBuffer);
+        }
+        profiler.endScope(commandBuffer, renderPassScope);
+    }
+
+    void LardRenderer::beginSwapChainRendering(VkCommandBuffer commandBuffer, VkClearValue colorClear, VkClearValue depthClear, VkSubpassContents contents) {
+        // without a render pass the layout transitions its subpass dependency did are explicit,
+        // previous contents of both attachments are cleared anyway so they start from UNDEFINED
+        std::array<VkImageMemoryBarrier, 2> barriers{};
+        barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[0].srcAccessMask = 0;
+        barriers[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].image = lardSwapChain->getImage(currentImageIndex);
+        barriers[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+        // the depth image of this frame slot was last written by an earlier frame on the same queue
+        barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].image = lardSwapChain->getDepthImage(currentFrameIndex);
+        barriers[1].subresourceRange = { lardSwapChain->getSwapChainDepthAspect(), 0, 1, 0, 1 };
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            static_cast<uint32_t>(barriers.size()), barriers.data());
+
+        VkRenderingAttachmentInfoKHR colorAttachment{};
+        colorAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+        colorAttachment.imageView = lardSwapChain->getImageView(currentImageIndex);
+        colorAttachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        colorAttachment.clearValue = colorClear;
+
+        VkRenderingAttachmentInfoKHR depthAttachment{};
+        depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+        depthAttachment.imageView = lardSwapChain->getDepthImageView(currentFrameIndex);
+        depthAttachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.clearValue = depthClear;
+
+        VkRenderingInfoKHR renderingInfo{};
+        renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+        renderingInfo.renderArea.offset = { 0, 0 };
+        renderingInfo.renderArea.extent = lardSwapChain->getSwapChainExtent();
+        renderingInfo.layerCount = 1;
+        renderingInfo.colorAttachmentCount = 1;
+        renderingInfo.pColorAttachments = &colorAttachment;
+        renderingInfo.pDepthAttachment = &depthAttachment;
+        if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) {
+            renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+        }
+
+        lardDevice.cmdBeginRendering(commandBuffer, &renderingInfo);
+    }
+
+    void LardRenderer::endSwapChainRendering(VkCommandBuffer commandBuffer) {
+        lardDevice.cmdEndRendering(commandBuffer);
+
+        // same final layout the render pass would have left the image in
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        barrier.newLayout = lardDevice.isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = lardSwapChain->getImage(currentImageIndex);
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
 
-        vkCmdEndRenderPass(commandBuffer);
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier);
     }
 }
\ No newline at end of file
@@ -2,9 +2,16 @@
 
 #include <memory>
 #include <cassert>
+#include <chrono>
+#include <deque>
 #include <vector>
 
+#include "lard_command_recorder.hpp"
 #include "lard_device.hpp"
+#include "lard_frame_allocator.hpp"
+#include "lard_pipeline.hpp"
+#include "lard_profiler.hpp"
+#include "lard_render_graph.hpp"
 #include "lard_swap_chain.hpp"
 #include "lard_window.hpp"
 #
@@ -12,7 +19,24 @@
 namespace lard {
     class LardRenderer {
     public:
-        LardRenderer(LardWindow& window, LardDevice& device);
+        // Input-to-present latency, measured from beginFrame (the app polls input right before it)
+        // until the frame's GPU work has retired on the frame timeline. Completion is observed on
+        // the CPU's next timeline check, and the time the presentation engine then holds the image
+        // is not included.
+        struct LatencyStats {
+            uint32_t frameCount = 0;
+            double averageMs = 0.0;
+            double maxMs = 0.0;
+        };
+
+        LardRenderer(LardWindow& window, LardDevice& device, LardFrameProfile profile = LardFrameProfile::HighThroughput)
+            : LardRenderer{ &window, device, window.getExtent(), profile } {}
+        // without a window (headless device) frames go to offscreen images of the given extent
+        LardRenderer(
+            LardWindow* window,
+            LardDevice& device,
+            VkExtent2D extent,
+            LardFrameProfile profile = LardFrameProfile::HighThroughput);
         ~LardRenderer();
         LardRenderer(const LardRenderer&) = delete;
         LardRenderer& operator=(const LardRenderer&) = delete;
@@ -23,6 +47,14 @@ namespace lard {
         VkRenderPass getSwapChainRenderPass() const {
             return lardSwapChain->getRenderPass();
         }
+        // what pipelines drawing inside the swap chain pass are built against, the render pass is
+        // VK_NULL_HANDLE under dynamic rendering and only the formats matter
+        LardRenderTargetInfo getSwapChainRenderTarget() const {
+            return { lardSwapChain->getRenderPass(), lardSwapChain->getSwapChainImageFormat(), lardSwapChain->getSwapChainDepthFormat() };
+        }
+        size_t getSwapChainImageCount() const { return lardSwapChain->imageCount(); }
+        int getFramesInFlight() const { return lardSwapChain->framesInFlight(); }
+        const LardAttachmentPool& getSwapChainAttachments() const { return lardSwapChain->getAttachmentPool(); }
         VkCommandBuffer getCurrentCommandBuffer() const {
             assert(isFrameInProgress() && "Cannot get command buffer when frame not in progress");
             return commandBuffers[currentFrameIndex];
@@ -31,20 +63,77 @@ namespace lard {
             assert(isFrameStarted && "Cannot get frame index when frame not in progress");
             return currentFrameIndex;
         }
+        // transient per-frame data, only valid to allocate from between beginFrame and endFrame
+        LardFrameAllocator& getFrameAllocator() {
+            assert(isFrameStarted && "Cannot get frame allocator when frame not in progress");
+            return frameAllocator;
+        }
+        LardProfiler& getProfiler() { return profiler; }
+        // secondary command buffers for the current frame, recorded on worker threads
+        LardCommandRecorder& getCommandRecorder() {
+            assert(isFrameStarted && "Cannot get command recorder when frame not in progress");
+            return commandRecorder;
+        }
+        // for secondary buffers executed inside beginSwapChainRenderPass(..., SECONDARY_COMMAND_BUFFERS)
+        LardSecondaryInheritance getSwapChainInheritance() const;
+        LardFrameProfile getFrameProfile() const { return frameProfile; }
+        // rebuilds the swap chain with the new present mode and frame count, between frames only
+        void setFrameProfile(LardFrameProfile profile);
+
+        LatencyStats getLatencyStats() const { return latencyStats; }
+        void resetLatencyStats() { latencyStats = LatencyStats{}; }
+
+        VkClearColorValue getClearColor() const { return { { 0.01f, 0.01f, 0.01f, 1.0f } }; }
+
+        // Per-frame render graph, reset by beginFrame with the swap chain color image and this
+        // frame's depth image imported. Needs dynamic rendering, render systems use
+        // beginSwapChainRenderPass otherwise.
+        bool supportsRenderGraph() const { return lardSwapChain->usesDynamicRendering(); }
+        LardRenderGraph& getRenderGraph() {
+            assert(isFrameStarted && "Cannot get render graph when frame not in progress");
+            return renderGraph;
+        }
+        LardRenderGraph::ResourceId getSwapChainColor() const { return swapChainColor; }
+        LardRenderGraph::ResourceId getSwapChainDepth() const { return swapChainDepth; }
+        // compiles the passes added this frame and records them, instead of the swap chain render pass
+        void executeRenderGraph(VkCommandBuffer commandBuffer);
+
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS only vkCmdExecuteCommands may follow
+        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
     private:
         void createCommandBuffers();
         void freeCommandBuffers();
-        void recreateSwapChain();
+        // false while the window is minimized, the old swap chain is kept in that case
+        bool recreateSwapChain();
+        void collectLatency();
+        void importSwapChainImages();
+        void beginSwapChainRendering(VkCommandBuffer commandBuffer, VkClearValue colorClear, VkClearValue depthClear, VkSubpassContents contents);
+        void endSwapChainRendering(VkCommandBuffer commandBuffer);
 
-        LardWindow& lardWindow;
+        LardWindow* lardWindow;
+        VkExtent2D headlessExtent;
         LardDevice& lardDevice;
         std::unique_ptr<LardSwapChain> lardSwapChain;
         std::vector<VkCommandBuffer> commandBuffers;
+        LardFrameAllocator frameAllocator;
+        LardRenderGraph renderGraph;
+        LardRenderGraph::ResourceId swapChainColor{ LardRenderGraph::INVALID_RESOURCE };
+        LardRenderGraph::ResourceId swapChainDepth{ LardRenderGraph::INVALID_RESOURCE };
+        LardProfiler profiler;
+        LardCommandRecorder commandRecorder;
+        uint32_t frameScope{ LardProfiler::INVALID_SCOPE };
+        uint32_t renderPassScope{ LardProfiler::INVALID_SCOPE };
+        LardFrameProfile frameProfile;
+
+        std::deque<std::pair<uint64_t, std::chrono::steady_clock::time_point>> pendingLatency;
+        LatencyStats latencyStats;
+
+        bool swapChainDirty{ false };
+        uint64_t recreatedAtFrame{ 0 };
 
         uint32_t currentImageIndex;
         int currentFrameIndex{ 0 };
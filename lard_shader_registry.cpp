@@ -0,0 +1,111 @@
+#include "lard_shader_registry.hpp"
+
+// std headers
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+
+namespace lard {
+
+    namespace {
+        // glslc -mfmt=num output, generated by the Makefile next to each shader source
+        constexpr uint32_t simpleShaderVert[] = {
+#include "shaders/simple_shader.vert.inc"
+        };
+        constexpr uint32_t simpleShaderInstancedVert[] = {
+#include "shaders/simple_shader_instanced.vert.inc"
+        };
+        constexpr uint32_t simpleShaderIndirectVert[] = {
+#include "shaders/simple_shader_indirect.vert.inc"
+        };
+        constexpr uint32_t simpleShaderFrag[] = {
+#include "shaders/simple_shader.frag.inc"
+        };
+        constexpr uint32_t cullObjectsComp[] = {
+#include "shaders/cull_objects.comp.inc"
+        };
+        constexpr uint32_t animateObjectsComp[] = {
+#include "shaders/animate_objects.comp.inc"
+        };
+
+        struct EmbeddedShader {
+            const char* name;
+            const uint32_t* code;
+            size_t size;
+        };
+
+        constexpr EmbeddedShader embeddedShaders[] = {
+            { "simple_shader.vert", simpleShaderVert, sizeof(simpleShaderVert) },
+            { "simple_shader_instanced.vert", simpleShaderInstancedVert, sizeof(simpleShaderInstancedVert) },
+            { "simple_shader_indirect.vert", simpleShaderIndirectVert, sizeof(simpleShaderIndirectVert) },
+            { "simple_shader.frag", simpleShaderFrag, sizeof(simpleShaderFrag) },
+            { "cull_objects.comp", cullObjectsComp, sizeof(cullObjectsComp) },
+            { "animate_objects.comp", animateObjectsComp, sizeof(animateObjectsComp) },
+        };
+
+        std::mutex overrideMutex;
+        std::string overrideDirectory;
+
+        // null if the file does not exist
+        std::shared_ptr<const std::vector<uint32_t>> readSpirvFile(const std::string& filepath) {
+            std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
+            if (!file.is_open()) {
+                return nullptr;
+            }
+
+            size_t fileSize = static_cast<size_t>(file.tellg());
+            if (fileSize % sizeof(uint32_t) != 0) {
+                throw std::runtime_error("Not a SPIR-V file: " + filepath);
+            }
+            auto code = std::make_shared<std::vector<uint32_t>>(fileSize / sizeof(uint32_t));
+            file.seekg(0);
+            file.read(reinterpret_cast<char*>(code->data()), fileSize);
+            if (!file) {
+                throw std::runtime_error("Failed to read file: " + filepath);
+            }
+            return code;
+        }
+    }
+
+    void LardShaderRegistry::setOverrideDirectory(std::string directory) {
+        std::lock_guard<std::mutex> lock{ overrideMutex };
+        overrideDirectory = std::move(directory);
+    }
+
+    LardShaderCode LardShaderRegistry::get(const std::string& name) {
+        std::string directory;
+        {
+            std::lock_guard<std::mutex> lock{ overrideMutex };
+            directory = overrideDirectory;
+        }
+
+        LardShaderCode shader{};
+        if (!directory.empty()) {
+            // re-read every time so a recompiled shader is picked up by the next pipeline
+            if (auto code = readSpirvFile(directory + "/" + name + ".spv")) {
+                shader.code = code->data();
+                shader.size = code->size() * sizeof(uint32_t);
+                shader.owned = std::move(code);
+                return shader;
+            }
+        }
+
+        for (const auto& embedded : embeddedShaders) {
+            if (name == embedded.name) {
+                shader.code = embedded.code;
+                shader.size = embedded.size;
+                return shader;
+            }
+        }
+        throw std::runtime_error("Unknown shader: " + name);
+    }
+
+    std::vector<std::string> LardShaderRegistry::embeddedNames() {
+        std::vector<std::string> names;
+        for (const auto& embedded : embeddedShaders) {
+            names.push_back(embedded.name);
+        }
+        return names;
+    }
+
+}  // namespace lard
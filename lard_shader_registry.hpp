@@ -0,0 +1,35 @@
+#pragma once
+
+// std lib headers
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lard {
+
+    // SPIR-V of one shader stage. Embedded code is referenced in place, code loaded from disk is
+    // kept alive by owned for as long as any copy of this exists.
+    struct LardShaderCode {
+        const uint32_t* code = nullptr;
+        size_t size = 0;  // in bytes
+        std::shared_ptr<const std::vector<uint32_t>> owned;
+    };
+
+    // The shaders compiled into the binary, keyed by source file name, e.g. "simple_shader.vert".
+    // The Makefile compiles every shaders/*.vert, *.frag and *.comp with glslc -mfmt=num into a .inc
+    // file that lard_shader_registry.cpp includes as a constant array, so startup neither
+    // depends on the working directory nor reads any file.
+    class LardShaderRegistry {
+    public:
+        // When set, get() loads <directory>/<name>.spv from disk first and only falls back to the
+        // embedded code if that file does not exist. For iterating on shaders without relinking.
+        static void setOverrideDirectory(std::string directory);
+
+        // safe to call from any thread, throws if name is neither on disk nor embedded
+        static LardShaderCode get(const std::string& name);
+        static std::vector<std::string> embeddedNames();
+    };
+
+}  // namespace lard
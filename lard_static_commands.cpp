@@ -0,0 +1,82 @@
+#include "lard_static_commands.hpp"
+
+// std headers
+#include <cassert>
+#include <stdexcept>
+
+namespace lard {
+
+    LardStaticCommands::LardStaticCommands(LardDevice& device, uint32_t frameCount) : lardDevice{ device } {
+        QueueFamilyIndices queueFamilyIndices = lardDevice.findPhysicalQueueFamilies();
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
+        // slots are re-recorded individually
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        if (vkCreateCommandPool(lardDevice.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create command pool!");
+        }
+
+        std::vector<VkCommandBuffer> commandBuffers(frameCount);
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandPool = commandPool;
+        allocInfo.commandBufferCount = frameCount;
+        if (vkAllocateCommandBuffers(lardDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate secondary command buffers!");
+        }
+
+        slots.resize(frameCount);
+        for (uint32_t i = 0; i < frameCount; i++) {
+            slots[i].commandBuffer = commandBuffers[i];
+        }
+    }
+
+    LardStaticCommands::~LardStaticCommands() {
+        // the last frames may still be executing the buffers
+        VkDevice device = lardDevice.device();
+        VkCommandPool pool = commandPool;
+        lardDevice.deferDestroy([device, pool]() { vkDestroyCommandPool(device, pool, nullptr); });
+    }
+
+    bool LardStaticCommands::isCompatible(const LardSecondaryInheritance& a, const LardSecondaryInheritance& b) {
+        return a.renderPass == b.renderPass &&
+            a.colorFormat == b.colorFormat &&
+            a.depthFormat == b.depthFormat &&
+            a.extent.width == b.extent.width &&
+            a.extent.height == b.extent.height;
+    }
+
+    void LardStaticCommands::execute(
+        VkCommandBuffer primary,
+        uint32_t frameIndex,
+        const LardSecondaryInheritance& inheritance,
+        const RecordFn& record) {
+        assert(frameIndex < slots.size() && "Frame index out of range");
+        Slot& slot = slots[frameIndex];
+
+        if (slot.generation != generation || !isCompatible(slot.inheritance, inheritance)) {
+            // the framebuffer is optional in the inheritance info, leaving it out keeps the
+            // buffer valid for every swap chain image
+            LardSecondaryInheritance staticInheritance = inheritance;
+            staticInheritance.framebuffer = VK_NULL_HANDLE;
+
+            // beginning implicitly resets the buffer, the slot's previous submission is done
+            LardCommandRecorder::beginSecondary(slot.commandBuffer, staticInheritance, 0);
+            record(slot.commandBuffer);
+            if (vkEndCommandBuffer(slot.commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to record static command buffer!");
+            }
+            slot.generation = generation;
+            slot.inheritance = staticInheritance;
+            stats.recordCount++;
+        } else {
+            stats.reuseCount++;
+        }
+
+        vkCmdExecuteCommands(primary, 1, &slot.commandBuffer);
+    }
+
+}  // namespace lard
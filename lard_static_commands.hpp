@@ -0,0 +1,62 @@
+#pragma once
+
+#include "lard_command_recorder.hpp"
+#include "lard_device.hpp"
+
+// std lib headers
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace lard {
+
+    // A draw list that is recorded once into a secondary command buffer per frame slot and
+    // re-executed every frame until it is invalidated. A slot is also re-recorded when the render
+    // pass, attachment formats or extent it was recorded for change, e.g. after a resize.
+    // Buffers are recorded without a framebuffer so they can be executed against any swap chain
+    // image, and one buffer per slot means a buffer is never re-recorded while still pending.
+    class LardStaticCommands {
+    public:
+        using RecordFn = std::function<void(VkCommandBuffer)>;
+
+        struct Stats {
+            uint64_t recordCount = 0;
+            uint64_t reuseCount = 0;
+        };
+
+        LardStaticCommands(LardDevice& device, uint32_t frameCount);
+        ~LardStaticCommands();
+        LardStaticCommands(const LardStaticCommands&) = delete;
+        LardStaticCommands& operator=(const LardStaticCommands&) = delete;
+
+        // every slot is re-recorded the next time it is executed
+        void invalidate() { generation++; }
+
+        // Executes frameIndex's buffer on primary, recording it with record first if it is stale.
+        // The render pass instance on primary must have been begun with secondary contents.
+        void execute(
+            VkCommandBuffer primary,
+            uint32_t frameIndex,
+            const LardSecondaryInheritance& inheritance,
+            const RecordFn& record);
+
+        Stats getStats() const { return stats; }
+        void resetStats() { stats = Stats{}; }
+
+    private:
+        struct Slot {
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            uint64_t generation = 0;  // 0 never recorded
+            LardSecondaryInheritance inheritance{};
+        };
+
+        static bool isCompatible(const LardSecondaryInheritance& a, const LardSecondaryInheritance& b);
+
+        LardDevice& lardDevice;
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        std::vector<Slot> slots;
+        uint64_t generation = 1;
+        Stats stats{};
+    };
+
+}  // namespace lard
@@ -11,21 +11,34 @@
 
 namespace lard {
 
-  LardSwapChain::LardSwapChain(LardDevice& deviceRef, VkExtent2D extent) : device{ deviceRef }, windowExtent{ extent } {
+  LardSwapChain::LardSwapChain(LardDevice& deviceRef, VkExtent2D extent, LardFrameProfile profile)
+    : device{ deviceRef }, windowExtent{ extent }, profile{ profile }, depthAttachments{ deviceRef } {
     init();
   }
 
-  LardSwapChain::LardSwapChain(LardDevice& deviceRef, VkExtent2D extent, std::shared_ptr<LardSwapChain> previous) : device{ deviceRef }, windowExtent{ extent }, oldSwapChain{ previous } {
+  LardSwapChain::LardSwapChain(
+    LardDevice& deviceRef,
+    VkExtent2D extent,
+    LardFrameProfile profile,
+    std::shared_ptr<LardSwapChain> previous)
+    : device{ deviceRef }, windowExtent{ extent }, profile{ profile }, depthAttachments{ deviceRef },
+    oldSwapChain{ previous } {
     init();
     oldSwapChain = nullptr;
   }
 
   void LardSwapChain::init() {
-    createSwapChain();
+    if (device.isHeadless()) {
+      createOffscreenImages();
+    } else {
+      createSwapChain();
+    }
     createImageViews();
-    createRenderPass();
     createDepthResources();
-    createFramebuffers();
+    if (!usesDynamicRendering()) {
+      createRenderPass();
+      createFramebuffers();
+    }
     createSyncObjects();
   }
 
@@ -40,33 +53,41 @@ namespace lard {
       swapChain = nullptr;
     }
 
-    for (int i = 0; i < depthImages.size(); i++) {
-      vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-      vkDestroyImage(device.device(), depthImages[i], nullptr);
-      vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+    for (size_t i = 0; i < offscreenImageAllocations.size(); i++) {
+      device.destroyImage(swapChainImages[i], offscreenImageAllocations[i]);
     }
 
     for (auto framebuffer : swapChainFramebuffers) {
       vkDestroyFramebuffer(device.device(), framebuffer, nullptr);
     }
 
-    vkDestroyRenderPass(device.device(), renderPass, nullptr);
+    if (renderPass != VK_NULL_HANDLE) {
+      vkDestroyRenderPass(device.device(), renderPass, nullptr);
+    }
 
     // cleanup synchronization objects
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-      vkDestroySemaphore(device.device(), renderFinishedSemaphores[i], nullptr);
-      vkDestroySemaphore(device.device(), imageAvailableSemaphores[i], nullptr);
-      vkDestroyFence(device.device(), inFlightFences[i], nullptr);
+    for (auto semaphore : renderFinishedSemaphores) {
+      vkDestroySemaphore(device.device(), semaphore, nullptr);
+    }
+    for (auto semaphore : imageAvailableSemaphores) {
+      vkDestroySemaphore(device.device(), semaphore, nullptr);
     }
   }
 
   VkResult LardSwapChain::acquireNextImage(uint32_t* imageIndex) {
-    vkWaitForFences(
-      device.device(),
-      1,
-      &inFlightFences[currentFrame],
-      VK_TRUE,
-      std::numeric_limits<uint64_t>::max());
+    // the frame about to start reuses the slot of the frame framesInFlight() before it,
+    // this is the only CPU wait per frame
+    uint64_t frame = device.currentFrame() + 1;
+    uint64_t inFlight = static_cast<uint64_t>(framesInFlight());
+    if (frame > inFlight) {
+      device.waitForFrame(frame - inFlight);
+    }
+
+    if (device.isHeadless()) {
+      // one image per frame in flight, the wait above already guards it
+      *imageIndex = static_cast<uint32_t>(currentFrame);
+      return VK_SUCCESS;
+    }
 
     VkResult result = vkAcquireNextImageKHR(
       device.device(),
@@ -81,38 +102,47 @@ namespace lard {
 
   VkResult LardSwapChain::submitCommandBuffers(
     const VkCommandBuffer* buffers, uint32_t* imageIndex) {
-    if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
-      vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
-    }
-    imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
+    // the frame timeline is signalled last, headless frames signal nothing else
+    uint64_t frameValue = device.currentFrame();
+    VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[*imageIndex], device.frameTimeline() };
+    uint64_t signalValues[] = { 0, frameValue };
+    uint32_t signalOffset = device.isHeadless() ? 1 : 0;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 2 - signalOffset;
+    timelineInfo.pSignalSemaphoreValues = signalValues + signalOffset;
 
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
 
     VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
     VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.waitSemaphoreCount = device.isHeadless() ? 0 : 1;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
 
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = buffers;
 
-    VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
+    submitInfo.signalSemaphoreCount = 2 - signalOffset;
+    submitInfo.pSignalSemaphores = signalSemaphores + signalOffset;
 
-    vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
-    if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
-      VK_SUCCESS) {
+    if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
       throw std::runtime_error("failed to submit draw command buffer!");
     }
 
+    if (device.isHeadless()) {
+      currentFrame = (currentFrame + 1) % framesInFlight();
+      return VK_SUCCESS;
+    }
+
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
     presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+    presentInfo.pWaitSemaphores = &renderFinishedSemaphores[*imageIndex];
 
     VkSwapchainKHR swapChains[] = { swapChain };
     presentInfo.swapchainCount = 1;
@@ -122,7 +152,7 @@ namespace lard {
 
     auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
 
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    currentFrame = (currentFrame + 1) % framesInFlight();
 
     return result;
   }
@@ -134,7 +164,11 @@ namespace lard {
     VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
     VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
-    uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
+    // low latency keeps as few images queued for presentation as the surface allows
+    uint32_t imageCount = swapChainSupport.capabilities.minImageCount;
+    if (profile == LardFrameProfile::HighThroughput) {
+      imageCount++;
+    }
     if (swapChainSupport.capabilities.maxImageCount > 0 &&
       imageCount > swapChainSupport.capabilities.maxImageCount) {
       imageCount = swapChainSupport.capabilities.maxImageCount;
@@ -188,6 +222,41 @@ namespace lard {
     swapChainExtent = extent;
   }
 
+  void LardSwapChain::createOffscreenImages() {
+    swapChainImageFormat = device.findSupportedFormat(
+      { VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB },
+      VK_IMAGE_TILING_OPTIMAL,
+      VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+    swapChainExtent = windowExtent;
+    swapChain = VK_NULL_HANDLE;
+
+    swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+    offscreenImageAllocations.resize(MAX_FRAMES_IN_FLIGHT);
+    for (size_t i = 0; i < swapChainImages.size(); i++) {
+      VkImageCreateInfo imageInfo{};
+      imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+      imageInfo.imageType = VK_IMAGE_TYPE_2D;
+      imageInfo.extent.width = swapChainExtent.width;
+      imageInfo.extent.height = swapChainExtent.height;
+      imageInfo.extent.depth = 1;
+      imageInfo.mipLevels = 1;
+      imageInfo.arrayLayers = 1;
+      imageInfo.format = swapChainImageFormat;
+      imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+      imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+      imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+      imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+      imageInfo.flags = 0;
+
+      device.createImageWithInfo(
+        imageInfo,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        swapChainImages[i],
+        offscreenImageAllocations[i]);
+    }
+  }
+
   void LardSwapChain::createImageViews() {
     swapChainImageViews.resize(swapChainImages.size());
     for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -210,6 +279,16 @@ namespace lard {
   }
 
   void LardSwapChain::createRenderPass() {
+    // a resize keeps the formats, so the render pass, and every pipeline built against it, carry
+    // over to the new swap chain
+    if (oldSwapChain != nullptr && oldSwapChain->renderPass != VK_NULL_HANDLE &&
+      oldSwapChain->swapChainImageFormat == swapChainImageFormat &&
+      oldSwapChain->swapChainDepthFormat == findDepthFormat()) {
+      renderPass = oldSwapChain->renderPass;
+      oldSwapChain->renderPass = VK_NULL_HANDLE;
+      return;
+    }
+
     VkAttachmentDescription depthAttachment{};
     depthAttachment.format = findDepthFormat();
     depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -232,7 +311,9 @@ namespace lard {
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    // PRESENT_SRC_KHR needs VK_KHR_swapchain, offscreen images are left ready for readback
+    colorAttachment.finalLayout =
+      device.isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
     VkAttachmentReference colorAttachmentRef = {};
     colorAttachmentRef.attachment = 0;
@@ -268,9 +349,14 @@ namespace lard {
   }
 
   void LardSwapChain::createFramebuffers() {
-    swapChainFramebuffers.resize(imageCount());
-    for (size_t i = 0; i < imageCount(); i++) {
-      std::array<VkImageView, 2> attachments = { swapChainImageViews[i], depthImageViews[i] };
+    // depth is per frame in flight and color per swap chain image, so one framebuffer per pair
+    swapChainFramebuffers.resize(imageCount() * depthImages.size());
+    for (size_t i = 0; i < swapChainFramebuffers.size(); i++) {
+      size_t imageIndex = i % imageCount();
+      size_t frameIndex = i / imageCount();
+      std::array<VkImageView, 2> attachments = {
+        swapChainImageViews[imageIndex],
+        depthAttachments.getView(depthImages[frameIndex]) };
 
       VkExtent2D swapChainExtent = getSwapChainExtent();
       VkFramebufferCreateInfo framebufferInfo = {};
@@ -295,71 +381,40 @@ namespace lard {
   void LardSwapChain::createDepthResources() {
     VkFormat depthFormat = findDepthFormat();
     swapChainDepthFormat = depthFormat;
-    VkExtent2D swapChainExtent = getSwapChainExtent();
-
-    depthImages.resize(imageCount());
-    depthImageMemorys.resize(imageCount());
-    depthImageViews.resize(imageCount());
-
-    for (int i = 0; i < depthImages.size(); i++) {
-      VkImageCreateInfo imageInfo{};
-      imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-      imageInfo.imageType = VK_IMAGE_TYPE_2D;
-      imageInfo.extent.width = swapChainExtent.width;
-      imageInfo.extent.height = swapChainExtent.height;
-      imageInfo.extent.depth = 1;
-      imageInfo.mipLevels = 1;
-      imageInfo.arrayLayers = 1;
-      imageInfo.format = depthFormat;
-      imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-      imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-      imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
-      imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-      imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-      imageInfo.flags = 0;
-
-      device.createImageWithInfo(
-        imageInfo,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        depthImages[i],
-        depthImageMemorys[i]);
 
-      VkImageViewCreateInfo viewInfo{};
-      viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-      viewInfo.image = depthImages[i];
-      viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-      viewInfo.format = depthFormat;
-      viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-      viewInfo.subresourceRange.baseMipLevel = 0;
-      viewInfo.subresourceRange.levelCount = 1;
-      viewInfo.subresourceRange.baseArrayLayer = 0;
-      viewInfo.subresourceRange.layerCount = 1;
-
-      if (vkCreateImageView(device.device(), &viewInfo, nullptr, &depthImageViews[i]) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create texture image view!");
-      }
+    // depth is cleared at the start of the pass and never stored, so frames only need their own
+    // copy while in flight, not one per swap chain image, and it can live in lazily allocated memory
+    LardAttachmentDesc desc{};
+    desc.format = depthFormat;
+    desc.extent = getSwapChainExtent();
+    desc.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    desc.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+
+    depthImages.resize(framesInFlight());
+    for (auto& depthImage : depthImages) {
+      depthImage = depthAttachments.request(desc);
     }
+    depthAttachments.build();
   }
 
   void LardSwapChain::createSyncObjects() {
     imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-    imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+    renderFinishedSemaphores.resize(imageCount());
 
     VkSemaphoreCreateInfo semaphoreInfo = {};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-    VkFenceCreateInfo fenceInfo = {};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
       if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) !=
-        VK_SUCCESS ||
-        vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
-        VK_SUCCESS ||
-        vkCreateFence(device.device(), &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
+        VK_SUCCESS) {
+        throw std::runtime_error("failed to create synchronization objects for a frame!");
+      }
+    }
+    // a present may still wait on an image's semaphore after its frame slot came around again,
+    // so these follow the image rather than the frame
+    for (size_t i = 0; i < imageCount(); i++) {
+      if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) !=
+        VK_SUCCESS) {
         throw std::runtime_error("failed to create synchronization objects for a frame!");
       }
     }
@@ -379,20 +434,22 @@ namespace lard {
 
   VkPresentModeKHR LardSwapChain::chooseSwapPresentMode(
     const std::vector<VkPresentModeKHR>& availablePresentModes) {
-    for (const auto& availablePresentMode : availablePresentModes) {
-      if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
-        std::cout << "Present mode: Mailbox" << std::endl;
-        return availablePresentMode;
+    if (profile == LardFrameProfile::LowLatency) {
+      // IMMEDIATE may tear but shows a frame the moment it is done, MAILBOX never tears
+      for (const auto& availablePresentMode : availablePresentModes) {
+        if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
+          std::cout << "Present mode: Immediate" << std::endl;
+          return availablePresentMode;
+        }
+      }
+      for (const auto& availablePresentMode : availablePresentModes) {
+        if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
+          std::cout << "Present mode: Mailbox" << std::endl;
+          return availablePresentMode;
+        }
       }
     }
 
-    // for (const auto &availablePresentMode : availablePresentModes) {
-    //   if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
-    //     std::cout << "Present mode: Immediate" << std::endl;
-    //     return availablePresentMode;
-    //   }
-    // }
-
     std::cout << "Present mode: V-Sync" << std::endl;
     return VK_PRESENT_MODE_FIFO_KHR;
   }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "lard_attachment_pool.hpp"
 #include "lard_device.hpp"
 
 // vulkan headers
@@ -12,20 +13,48 @@
 
 namespace lard {
 
+  enum class LardFrameProfile {
+    LowLatency,      // 1 frame in flight, IMMEDIATE or MAILBOX, fewest swap chain images
+    HighThroughput,  // MAX_FRAMES_IN_FLIGHT frames in flight, FIFO
+  };
+
+  // On a headless device the swap chain is emulated with offscreen color images that are
+  // rendered in turn and left in TRANSFER_SRC_OPTIMAL, nothing is acquired or presented.
+  //
+  // With dynamic rendering there is no render pass and no framebuffers, getRenderPass() returns
+  // VK_NULL_HANDLE and the renderer transitions the images itself.
   class LardSwapChain {
   public:
-    static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
-
-    LardSwapChain(LardDevice& deviceRef, VkExtent2D windowExtent);
-    LardSwapChain(LardDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<LardSwapChain> previous);
+    // upper bound for per-frame resources, framesInFlight() is what the profile actually uses
+    static constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+
+    LardSwapChain(LardDevice& deviceRef, VkExtent2D windowExtent, LardFrameProfile profile);
+    LardSwapChain(
+      LardDevice& deviceRef,
+      VkExtent2D windowExtent,
+      LardFrameProfile profile,
+      std::shared_ptr<LardSwapChain> previous);
     ~LardSwapChain();
 
     LardSwapChain(const LardSwapChain&) = delete;
     LardSwapChain& operator=(const LardSwapChain&) = delete;
 
-    VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
+    VkFramebuffer getFrameBuffer(int imageIndex, int frameIndex) {
+      return swapChainFramebuffers[frameIndex * imageCount() + imageIndex];
+    }
     VkRenderPass getRenderPass() { return renderPass; }
+    VkImage getImage(int index) { return swapChainImages[index]; }
     VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+    // depth attachments are per frame in flight, not per swap chain image
+    VkImage getDepthImage(int frameIndex) { return depthAttachments.getImage(depthImages[frameIndex]); }
+    VkImageView getDepthImageView(int frameIndex) { return depthAttachments.getView(depthImages[frameIndex]); }
+    const LardAttachmentPool& getAttachmentPool() const { return depthAttachments; }
+    VkFormat getSwapChainDepthFormat() { return swapChainDepthFormat; }
+    VkImageAspectFlags getSwapChainDepthAspect() {
+      bool stencil = swapChainDepthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || swapChainDepthFormat == VK_FORMAT_D24_UNORM_S8_UINT;
+      return VK_IMAGE_ASPECT_DEPTH_BIT | (stencil ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+    }
+    bool usesDynamicRendering() { return device.hasDynamicRendering(); }
     size_t imageCount() { return swapChainImages.size(); }
     VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
     VkExtent2D getSwapChainExtent() { return swapChainExtent; }
@@ -37,6 +66,9 @@ namespace lard {
     }
     VkFormat findDepthFormat();
 
+    LardFrameProfile getProfile() const { return profile; }
+    int framesInFlight() const { return profile == LardFrameProfile::LowLatency ? 1 : MAX_FRAMES_IN_FLIGHT; }
+
     VkResult acquireNextImage(uint32_t* imageIndex);
     VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
 
@@ -47,6 +79,7 @@ namespace lard {
   private:
     void init();
     void createSwapChain();
+    void createOffscreenImages();
     void createImageViews();
     void createDepthResources();
     void createRenderPass();
@@ -65,24 +98,25 @@ namespace lard {
     VkExtent2D swapChainExtent;
 
     std::vector<VkFramebuffer> swapChainFramebuffers;
-    VkRenderPass renderPass;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
 
-    std::vector<VkImage> depthImages;
-    std::vector<VkDeviceMemory> depthImageMemorys;
-    std::vector<VkImageView> depthImageViews;
+    std::vector<LardAttachmentPool::Handle> depthImages;
     std::vector<VkImage> swapChainImages;
+    std::vector<LardAllocation> offscreenImageAllocations;
     std::vector<VkImageView> swapChainImageViews;
 
     LardDevice& device;
     VkExtent2D windowExtent;
+    LardFrameProfile profile;
+    LardAttachmentPool depthAttachments;
 
     VkSwapchainKHR swapChain;
     std::shared_ptr<LardSwapChain> oldSwapChain;
 
-    std::vector<VkSemaphore> imageAvailableSemaphores;
-    std::vector<VkSemaphore> renderFinishedSemaphores;
-    std::vector<VkFence> inFlightFences;
-    std::vector<VkFence> imagesInFlight;
+    // CPU/GPU pacing runs on the device's frame timeline, these binary semaphores only exist
+    // because acquire and present cannot use timeline semaphores
+    std::vector<VkSemaphore> imageAvailableSemaphores;  // per frame in flight
+    std::vector<VkSemaphore> renderFinishedSemaphores;  // per swap chain image
     size_t currentFrame = 0;
   };
 
@@ -0,0 +1,109 @@
+#include "lard_thread_pool.hpp"
+
+// std headers
+#include <algorithm>
+#include <exception>
+
+namespace lard {
+
+    LardThreadPool::LardThreadPool(uint32_t threadCount) {
+        if (threadCount == 0) {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (uint32_t i = 0; i < threadCount; i++) {
+            workers.emplace_back(&LardThreadPool::workerLoop, this, i);
+        }
+    }
+
+    LardThreadPool::~LardThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock{ mutex };
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    void LardThreadPool::parallelFor(uint32_t count, const Job& job) {
+        if (count == 0) {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock{ mutex };
+        currentJob = &job;
+        jobCount = count;
+        nextJob = 0;
+        finishedJobs = 0;
+        error = nullptr;
+        workAvailable.notify_all();
+
+        workDone.wait(lock, [this] { return finishedJobs == jobCount; });
+        currentJob = nullptr;
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void LardThreadPool::submit(Task task) {
+        {
+            std::lock_guard<std::mutex> lock{ mutex };
+            tasks.push_back(std::move(task));
+            pendingTasks++;
+        }
+        workAvailable.notify_one();
+    }
+
+    void LardThreadPool::waitIdle() {
+        std::unique_lock<std::mutex> lock{ mutex };
+        tasksDone.wait(lock, [this] { return pendingTasks == 0; });
+    }
+
+    void LardThreadPool::workerLoop(uint32_t thread) {
+        std::unique_lock<std::mutex> lock{ mutex };
+        while (true) {
+            workAvailable.wait(lock, [this] {
+                return stopping || (currentJob != nullptr && nextJob < jobCount) || !tasks.empty();
+            });
+            if (stopping) {
+                return;
+            }
+
+            if (currentJob == nullptr || nextJob == jobCount) {
+                Task task = std::move(tasks.front());
+                tasks.pop_front();
+                lock.unlock();
+                try {
+                    task();
+                } catch (...) {
+                    // nobody to report to, tasks are expected to catch their own errors
+                }
+                lock.lock();
+                if (--pendingTasks == 0) {
+                    tasksDone.notify_all();
+                }
+                continue;
+            }
+
+            uint32_t index = nextJob++;
+            const Job& job = *currentJob;
+            lock.unlock();
+            std::exception_ptr jobError;
+            try {
+                job(index, thread);
+            } catch (...) {
+                jobError = std::current_exception();
+            }
+            lock.lock();
+
+            if (jobError && !error) {
+                error = jobError;
+            }
+            if (++finishedJobs == jobCount) {
+                workDone.notify_one();
+            }
+        }
+    }
+
+}  // namespace lard
@@ -0,0 +1,61 @@
+#pragma once
+
+// std lib headers
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lard {
+
+    // Fixed set of worker threads. Every job learns the index of the worker running it, so
+    // per-thread resources (command pools) can be used without locking. Besides blocking
+    // parallelFor batches it runs fire-and-forget tasks, batches take priority over queued tasks.
+    class LardThreadPool {
+    public:
+        using Job = std::function<void(uint32_t job, uint32_t thread)>;
+        using Task = std::function<void()>;
+
+        // 0 picks one worker per hardware thread
+        explicit LardThreadPool(uint32_t threadCount = 0);
+        ~LardThreadPool();
+        LardThreadPool(const LardThreadPool&) = delete;
+        LardThreadPool& operator=(const LardThreadPool&) = delete;
+
+        uint32_t size() const { return static_cast<uint32_t>(workers.size()); }
+
+        // runs job(0 .. jobCount - 1) on the workers and returns once all of them are done,
+        // the first exception thrown by a job is rethrown here
+        void parallelFor(uint32_t jobCount, const Job& job);
+
+        // queues task and returns immediately, task must handle its own exceptions
+        void submit(Task task);
+        // blocks until every submitted task has run, tasks still queued on destruction are dropped
+        void waitIdle();
+
+    private:
+        void workerLoop(uint32_t thread);
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::condition_variable workDone;
+        std::condition_variable tasksDone;
+
+        // the batch being run, guarded by mutex
+        const Job* currentJob = nullptr;
+        uint32_t jobCount = 0;
+        uint32_t nextJob = 0;
+        uint32_t finishedJobs = 0;
+        std::exception_ptr error;
+        // submitted tasks, guarded by mutex; pendingTasks counts queued and running ones
+        std::deque<Task> tasks;
+        uint32_t pendingTasks = 0;
+        bool stopping = false;
+    };
+
+}  // namespace lard
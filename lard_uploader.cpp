@@ -0,0 +1,383 @@
+#include "lard_uploader.hpp"
+
+// std headers
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace lard {
+
+    // copies out of the ring start on this boundary, enough for any buffer or texel copy
+    static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+    LardUploader::LardUploader(LardDevice& device, VkDeviceSize ringSize) : lardDevice{ device } {
+        QueueFamilyIndices indices = lardDevice.findPhysicalQueueFamilies();
+        transferFamily = indices.transferFamily;
+        graphicsFamily = indices.graphicsFamily;
+        ownershipTransfer = indices.hasDedicatedTransfer();
+
+        createCommandPools();
+        createTimeline();
+
+        segmentSize = ringSize / RING_SEGMENT_COUNT;
+        lardDevice.createBuffer(
+            segmentSize * RING_SEGMENT_COUNT,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            ringBuffer,
+            ringAllocation);
+    }
+
+    LardUploader::~LardUploader() {
+        // whatever is still queued targets resources that are already gone
+        pendingBufferCopies.clear();
+        pendingImageCopies.clear();
+        wait({ lastSubmittedValue });
+
+        vkDestroyCommandPool(lardDevice.device(), transferCommandPool, nullptr);
+        if (acquireCommandPool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(lardDevice.device(), acquireCommandPool, nullptr);
+        }
+        vkDestroySemaphore(lardDevice.device(), timeline, nullptr);
+        lardDevice.destroyBuffer(ringBuffer, ringAllocation);
+    }
+
+    void LardUploader::createCommandPools() {
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = transferFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        if (vkCreateCommandPool(lardDevice.device(), &poolInfo, nullptr, &transferCommandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create transfer command pool!");
+        }
+
+        if (ownershipTransfer) {
+            poolInfo.queueFamilyIndex = graphicsFamily;
+            if (vkCreateCommandPool(lardDevice.device(), &poolInfo, nullptr, &acquireCommandPool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create upload acquire command pool!");
+            }
+        }
+    }
+
+    void LardUploader::createTimeline() {
+        VkSemaphoreTypeCreateInfo typeInfo = {};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+
+        if (vkCreateSemaphore(lardDevice.device(), &semaphoreInfo, nullptr, &timeline) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upload timeline semaphore!");
+        }
+    }
+
+    LardUploadToken LardUploader::uploadBuffer(
+        VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size) {
+        auto bytes = static_cast<const char*>(data);
+
+        while (size > 0) {
+            segmentHead = (segmentHead + STAGING_ALIGNMENT - 1) & ~(STAGING_ALIGNMENT - 1);
+            if (segmentHead >= segmentSize) {
+                advanceRingSegment();
+            }
+
+            VkDeviceSize chunk = std::min(size, segmentSize - segmentHead);
+            // a flush for the next chunk must not hand the buffer to graphics half written
+            splitDstBuffer = chunk < size ? dstBuffer : VK_NULL_HANDLE;
+            VkDeviceSize ringOffset = currentSegment * segmentSize + segmentHead;
+            memcpy(static_cast<char*>(ringAllocation.mappedData) + ringOffset, bytes, static_cast<size_t>(chunk));
+
+            PendingBufferCopy copy{};
+            copy.srcBuffer = ringBuffer;
+            copy.dstBuffer = dstBuffer;
+            copy.region.srcOffset = ringOffset;
+            copy.region.dstOffset = dstOffset;
+            copy.region.size = chunk;
+            pendingBufferCopies.push_back(copy);
+
+            segmentHead += chunk;
+            dstOffset += chunk;
+            bytes += chunk;
+            size -= chunk;
+        }
+        return pendingToken();
+    }
+
+    LardUploadToken LardUploader::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+        PendingBufferCopy copy{};
+        copy.srcBuffer = srcBuffer;
+        copy.dstBuffer = dstBuffer;
+        copy.region.srcOffset = 0;
+        copy.region.dstOffset = 0;
+        copy.region.size = size;
+        pendingBufferCopies.push_back(copy);
+        return pendingToken();
+    }
+
+    LardUploadToken LardUploader::copyBufferToImage(
+        VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount) {
+        PendingImageCopy copy{};
+        copy.srcBuffer = buffer;
+        copy.dstImage = image;
+        copy.region.bufferOffset = 0;
+        copy.region.bufferRowLength = 0;
+        copy.region.bufferImageHeight = 0;
+
+        copy.region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy.region.imageSubresource.mipLevel = 0;
+        copy.region.imageSubresource.baseArrayLayer = 0;
+        copy.region.imageSubresource.layerCount = layerCount;
+
+        copy.region.imageOffset = { 0, 0, 0 };
+        copy.region.imageExtent = { width, height, 1 };
+        pendingImageCopies.push_back(copy);
+        return pendingToken();
+    }
+
+    void LardUploader::advanceRingSegment() {
+        // the copies out of the current segment need a timeline value before it can be reused
+        flush();
+        currentSegment = (currentSegment + 1) % RING_SEGMENT_COUNT;
+        wait({ segmentValues[currentSegment] });
+        segmentHead = 0;
+    }
+
+    VkCommandBuffer LardUploader::allocateCommandBuffer(VkCommandPool pool) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandPool = pool;
+        allocInfo.commandBufferCount = 1;
+
+        VkCommandBuffer commandBuffer;
+        if (vkAllocateCommandBuffers(lardDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate upload command buffer!");
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer(commandBuffer, &beginInfo);
+        return commandBuffer;
+    }
+
+    void LardUploader::recordCopies(VkCommandBuffer commandBuffer) {
+        // one vkCmdCopyBuffer per source/destination pair, regions stay in queue order
+        std::stable_sort(
+            pendingBufferCopies.begin(),
+            pendingBufferCopies.end(),
+            [](const PendingBufferCopy& a, const PendingBufferCopy& b) {
+                return a.srcBuffer != b.srcBuffer ? a.srcBuffer < b.srcBuffer : a.dstBuffer < b.dstBuffer;
+            });
+
+        std::vector<VkBufferCopy> regions;
+        for (size_t i = 0; i < pendingBufferCopies.size();) {
+            VkBuffer srcBuffer = pendingBufferCopies[i].srcBuffer;
+            VkBuffer dstBuffer = pendingBufferCopies[i].dstBuffer;
+            regions.clear();
+            for (; i < pendingBufferCopies.size() && pendingBufferCopies[i].srcBuffer == srcBuffer &&
+                   pendingBufferCopies[i].dstBuffer == dstBuffer;
+                 i++) {
+                regions.push_back(pendingBufferCopies[i].region);
+            }
+            vkCmdCopyBuffer(
+                commandBuffer,
+                srcBuffer,
+                dstBuffer,
+                static_cast<uint32_t>(regions.size()),
+                regions.data());
+        }
+
+        for (const auto& copy : pendingImageCopies) {
+            vkCmdCopyBufferToImage(
+                commandBuffer,
+                copy.srcBuffer,
+                copy.dstImage,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                1,
+                &copy.region);
+        }
+    }
+
+    void LardUploader::recordOwnershipBarriers(VkCommandBuffer commandBuffer, bool release) {
+        std::vector<VkBuffer> buffers;
+        for (const auto& copy : pendingBufferCopies) {
+            if (copy.dstBuffer != splitDstBuffer) {
+                buffers.push_back(copy.dstBuffer);
+            }
+        }
+        std::sort(buffers.begin(), buffers.end());
+        buffers.erase(std::unique(buffers.begin(), buffers.end()), buffers.end());
+
+        std::vector<VkBufferMemoryBarrier> bufferBarriers;
+        for (VkBuffer buffer : buffers) {
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = release ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+            barrier.dstAccessMask = release ? 0 : VK_ACCESS_MEMORY_READ_BIT;
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            barrier.buffer = buffer;
+            barrier.offset = 0;
+            barrier.size = VK_WHOLE_SIZE;
+            bufferBarriers.push_back(barrier);
+        }
+
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        for (const auto& copy : pendingImageCopies) {
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = release ? VK_ACCESS_TRANSFER_WRITE_BIT : 0;
+            barrier.dstAccessMask = release ? 0 : VK_ACCESS_MEMORY_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            barrier.image = copy.dstImage;
+            barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            barrier.subresourceRange.baseMipLevel = 0;
+            barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+            barrier.subresourceRange.baseArrayLayer = 0;
+            barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+            imageBarriers.push_back(barrier);
+        }
+
+        // the timeline wait between the two submissions orders release before acquire
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            release ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            release ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+            0,
+            0,
+            nullptr,
+            static_cast<uint32_t>(bufferBarriers.size()),
+            bufferBarriers.data(),
+            static_cast<uint32_t>(imageBarriers.size()),
+            imageBarriers.data());
+    }
+
+    LardUploadToken LardUploader::flush() {
+        collect();
+        if (!hasPendingUploads()) {
+            return { lastSubmittedValue };
+        }
+
+        VkCommandBuffer transferCommandBuffer = allocateCommandBuffer(transferCommandPool);
+        recordCopies(transferCommandBuffer);
+        if (ownershipTransfer) {
+            recordOwnershipBarriers(transferCommandBuffer, true);
+        } else {
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+            vkCmdPipelineBarrier(
+                transferCommandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                0,
+                1,
+                &barrier,
+                0,
+                nullptr,
+                0,
+                nullptr);
+        }
+        vkEndCommandBuffer(transferCommandBuffer);
+
+        uint64_t transferValue = ++lastSubmittedValue;
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues = &transferValue;
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &transferCommandBuffer;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &timeline;
+
+        if (vkQueueSubmit(lardDevice.transferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit upload command buffer!");
+        }
+
+        Submission submission{ transferValue, transferCommandBuffer, VK_NULL_HANDLE };
+        if (ownershipTransfer) {
+            VkCommandBuffer acquireCommandBuffer = allocateCommandBuffer(acquireCommandPool);
+            recordOwnershipBarriers(acquireCommandBuffer, false);
+            vkEndCommandBuffer(acquireCommandBuffer);
+
+            uint64_t acquireValue = ++lastSubmittedValue;
+            VkTimelineSemaphoreSubmitInfo acquireTimelineInfo{};
+            acquireTimelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            acquireTimelineInfo.waitSemaphoreValueCount = 1;
+            acquireTimelineInfo.pWaitSemaphoreValues = &transferValue;
+            acquireTimelineInfo.signalSemaphoreValueCount = 1;
+            acquireTimelineInfo.pSignalSemaphoreValues = &acquireValue;
+
+            VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            VkSubmitInfo acquireInfo{};
+            acquireInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+            acquireInfo.pNext = &acquireTimelineInfo;
+            acquireInfo.waitSemaphoreCount = 1;
+            acquireInfo.pWaitSemaphores = &timeline;
+            acquireInfo.pWaitDstStageMask = &waitStage;
+            acquireInfo.commandBufferCount = 1;
+            acquireInfo.pCommandBuffers = &acquireCommandBuffer;
+            acquireInfo.signalSemaphoreCount = 1;
+            acquireInfo.pSignalSemaphores = &timeline;
+
+            if (vkQueueSubmit(lardDevice.graphicsQueue(), 1, &acquireInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+                throw std::runtime_error("failed to submit upload acquire command buffer!");
+            }
+
+            submission.value = acquireValue;
+            submission.acquireCommandBuffer = acquireCommandBuffer;
+        }
+
+        submissions.push_back(submission);
+        segmentValues[currentSegment] = lastSubmittedValue;
+        pendingBufferCopies.clear();
+        pendingImageCopies.clear();
+        return { lastSubmittedValue };
+    }
+
+    void LardUploader::wait(LardUploadToken token) {
+        if (token.value > lastSubmittedValue) {
+            flush();
+        }
+        if (isComplete(token)) {
+            return;
+        }
+
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &timeline;
+        waitInfo.pValues = &token.value;
+        if (vkWaitSemaphores(lardDevice.device(), &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+            throw std::runtime_error("failed to wait for upload!");
+        }
+        collect();
+    }
+
+    void LardUploader::collect() {
+        vkGetSemaphoreCounterValue(lardDevice.device(), timeline, &completedValue);
+
+        while (!submissions.empty() && submissions.front().value <= completedValue) {
+            auto& submission = submissions.front();
+            vkFreeCommandBuffers(lardDevice.device(), transferCommandPool, 1, &submission.transferCommandBuffer);
+            if (submission.acquireCommandBuffer != VK_NULL_HANDLE) {
+                vkFreeCommandBuffers(lardDevice.device(), acquireCommandPool, 1, &submission.acquireCommandBuffer);
+            }
+            submissions.pop_front();
+        }
+    }
+
+}  // namespace lard
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "lard_device.hpp"
+
+// std lib headers
+#include <array>
+#include <deque>
+#include <vector>
+
+namespace lard {
+
+    // Persistent, host visible staging ring used to fill device local resources. Uploads are
+    // only queued when requested, flush() records every queued copy into a single command
+    // buffer so loading many models costs one submission instead of one per model.
+    //
+    // Copies run on a dedicated transfer queue when the device has one, otherwise on the
+    // graphics queue. Completion is tracked with a timeline semaphore, every upload returns a
+    // token that can be polled with isComplete() or waited on with wait(). Resources written
+    // on the transfer queue are released to the graphics family and acquired there before the
+    // token completes, so a completed token means the data is ready for any graphics work.
+    class LardUploader {
+    public:
+        static constexpr VkDeviceSize DEFAULT_RING_SIZE = 32 * 1024 * 1024;
+        static constexpr uint32_t RING_SEGMENT_COUNT = 4;
+
+        LardUploader(LardDevice& device, VkDeviceSize ringSize = DEFAULT_RING_SIZE);
+        ~LardUploader();
+        LardUploader(const LardUploader&) = delete;
+        LardUploader& operator=(const LardUploader&) = delete;
+
+        LardUploadToken uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+        LardUploadToken copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        // image must be in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL and stays in it
+        LardUploadToken copyBufferToImage(
+            VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
+
+        LardUploadToken flush();
+        bool hasPendingUploads() const { return !pendingBufferCopies.empty() || !pendingImageCopies.empty(); }
+
+        bool isComplete(LardUploadToken token) const { return token.value <= completedValue; }
+        void wait(LardUploadToken token);
+        // refreshes the completed value and recycles command buffers of retired submissions
+        void collect();
+
+    private:
+        struct PendingBufferCopy {
+            VkBuffer srcBuffer;
+            VkBuffer dstBuffer;
+            VkBufferCopy region;
+        };
+        struct PendingImageCopy {
+            VkBuffer srcBuffer;
+            VkImage dstImage;
+            VkBufferImageCopy region;
+        };
+        struct Submission {
+            uint64_t value;
+            VkCommandBuffer transferCommandBuffer;
+            VkCommandBuffer acquireCommandBuffer;
+        };
+
+        void createCommandPools();
+        void createTimeline();
+        void advanceRingSegment();
+        LardUploadToken pendingToken() const {
+            return { lastSubmittedValue + (ownershipTransfer ? 2 : 1) };
+        }
+        VkCommandBuffer allocateCommandBuffer(VkCommandPool pool);
+        void recordCopies(VkCommandBuffer commandBuffer);
+        void recordOwnershipBarriers(VkCommandBuffer commandBuffer, bool release);
+
+        LardDevice& lardDevice;
+        uint32_t transferFamily;
+        uint32_t graphicsFamily;
+        bool ownershipTransfer;
+
+        VkCommandPool transferCommandPool;
+        VkCommandPool acquireCommandPool = VK_NULL_HANDLE;
+        VkSemaphore timeline;
+        uint64_t lastSubmittedValue = 0;
+        uint64_t completedValue = 0;
+        std::deque<Submission> submissions;
+
+        VkBuffer ringBuffer;
+        LardAllocation ringAllocation;
+        VkDeviceSize segmentSize;
+        uint32_t currentSegment = 0;
+        VkDeviceSize segmentHead = 0;
+        std::array<uint64_t, RING_SEGMENT_COUNT> segmentValues{};
+
+        std::vector<PendingBufferCopy> pendingBufferCopies;
+        std::vector<PendingImageCopy> pendingImageCopies;
+        // destination of an upload split across submissions, it stays with the transfer family
+        // until the submission carrying its last chunk releases it
+        VkBuffer splitDstBuffer = VK_NULL_HANDLE;
+    };
+
+}  // namespace lard
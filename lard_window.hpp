@@ -16,6 +16,7 @@ namespace lard {
             void resetWindowResizedFlag();
             void createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
             VkExtent2D getExtent();
+            GLFWwindow *getGLFWwindow() const { return window; }
 
         private:
             void initWindow();
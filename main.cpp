@@ -1,12 +1,91 @@
 #include "first_app.hpp"
+#include "lard_shader_registry.hpp"
 
+#include <chrono>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 
-int main() {
-    lard::FirstApp app{};
+int main(int argc, char **argv) {
+    // --headless, --low-latency, --profile, --parallel, --static, --instanced, --gpu-driven and --shader-dir may come first and combine with the other modes
+    bool headless = false;
+    bool profile = false;
+    bool parallel = false;
+    bool staticScene = false;
+    bool instanced = false;
+    bool gpuDriven = false;
+    auto frameProfile = lard::LardFrameProfile::HighThroughput;
+    int arg = 1;
+    for (; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[arg], "--low-latency") == 0) {
+            frameProfile = lard::LardFrameProfile::LowLatency;
+        } else if (strcmp(argv[arg], "--profile") == 0) {
+            profile = true;
+        } else if (strcmp(argv[arg], "--parallel") == 0) {
+            parallel = true;
+        } else if (strcmp(argv[arg], "--static") == 0) {
+            staticScene = true;
+        } else if (strcmp(argv[arg], "--instanced") == 0) {
+            instanced = true;
+        } else if (strcmp(argv[arg], "--gpu-driven") == 0) {
+            gpuDriven = true;
+        } else if (strcmp(argv[arg], "--shader-dir") == 0 && arg + 1 < argc) {
+            // load shaders/*.spv from disk over the embedded ones, e.g. --shader-dir shaders
+            lard::LardShaderRegistry::setOverrideDirectory(argv[++arg]);
+        } else {
+            break;
+        }
+    }
+
+    auto constructionStart = std::chrono::steady_clock::now();
+    lard::FirstApp app{headless, frameProfile};
+    double constructionSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - constructionStart).count();
+    if (profile) {
+        app.setProfilerSummaryInterval(600);
+    }
+    app.setParallelRecording(parallel);
+    app.setStaticScene(staticScene);
+    app.setInstancing(instanced);
+    app.setGpuDriven(gpuDriven);
     try {
+        if (argc > arg && strcmp(argv[arg], "--bench-vertex-placement") == 0) {
+            app.runVertexPlacementBenchmark(argc > arg + 1 ? atoi(argv[arg + 1]) : 2000);
+            return EXIT_SUCCESS;
+        }
+        if (argc > arg && strcmp(argv[arg], "--bench-latency") == 0) {
+            app.runLatencyBenchmark(argc > arg + 1 ? atoi(argv[arg + 1]) : 1000);
+            return EXIT_SUCCESS;
+        }
+        if (argc > arg && strcmp(argv[arg], "--bench-recording") == 0) {
+            app.runRecordingBenchmark(argc > arg + 1 ? atoi(argv[arg + 1]) : 500);
+            return EXIT_SUCCESS;
+        }
+        if (argc > arg && strcmp(argv[arg], "--bench-instancing") == 0) {
+            app.runInstancingBenchmark(
+                argc > arg + 1 ? atoi(argv[arg + 1]) : 500,
+                argc > arg + 2 ? atoi(argv[arg + 2]) : 100000);
+            return EXIT_SUCCESS;
+        }
+        if (argc > arg && strcmp(argv[arg], "--bench-gpu-driven") == 0) {
+            app.runGpuDrivenBenchmark(argc > arg + 1 ? atoi(argv[arg + 1]) : 300);
+            return EXIT_SUCCESS;
+        }
+        if (argc > arg && strcmp(argv[arg], "--report-startup") == 0) {
+            app.runStartupReport(constructionSeconds);
+            return EXIT_SUCCESS;
+        }
+        if (argc > arg && strcmp(argv[arg], "--report-attachments") == 0) {
+            app.runAttachmentReport();
+            return EXIT_SUCCESS;
+        }
+        if (headless) {
+            app.runHeadless(argc > arg ? atoi(argv[arg]) : 1000);
+            return EXIT_SUCCESS;
+        }
         app.run();
     } catch (const std::exception &e) {
         std::cerr << e.what() << "\n";
@@ -3,6 +3,11 @@
 layout(location = 0) in vec2 position;
 layout(location = 1) in vec3 color;
 
+layout(location = 0) out vec3 fragColor;
+
+// SimpleRenderSystem::VARIANT_VERTEX_COLOR, per vertex colors instead of the push constant color
+layout(constant_id = 0) const bool VERTEX_COLOR = false;
+
 layout(push_constant) uniform Push {
     mat2 transform;
     vec2 offset;
@@ -11,4 +16,5 @@ layout(push_constant) uniform Push {
 
 void main() {
     gl_Position = vec4(push.transform * position + push.offset , 0.0, 1.0);
+    fragColor = VERTEX_COLOR ? color : push.color;
 }
\ No newline at end of file
@@ -0,0 +1,26 @@
+#version 450
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec3 color;
+
+layout(location = 0) out vec3 fragColor;
+
+// SimpleRenderSystem::VARIANT_VERTEX_COLOR, per vertex colors instead of the object color
+layout(constant_id = 0) const bool VERTEX_COLOR = false;
+
+// SimpleRenderSystem's GpuObjectData, written for the frame by animate_objects.comp
+struct ObjectData {
+    mat2 transform;
+    vec2 offset;
+    vec3 color;
+    uint model;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects { ObjectData objects[]; };
+
+void main() {
+    // the indirect draw's firstInstance is the object's index
+    ObjectData object = objects[gl_InstanceIndex];
+    gl_Position = vec4(object.transform * position + object.offset, 0.0, 1.0);
+    fragColor = VERTEX_COLOR ? color : object.color;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#version 450
+
+layout(location = 0) in vec2 position;
+layout(location = 1) in vec3 color;
+
+// per instance, SimpleRenderSystem's SimpleInstanceData
+layout(location = 2) in mat2 instanceTransform;
+layout(location = 4) in vec2 instanceOffset;
+layout(location = 5) in vec3 instanceColor;
+
+layout(location = 0) out vec3 fragColor;
+
+// SimpleRenderSystem::VARIANT_VERTEX_COLOR, per vertex colors instead of the instance color
+layout(constant_id = 0) const bool VERTEX_COLOR = false;
+
+void main() {
+    gl_Position = vec4(instanceTransform * position + instanceOffset, 0.0, 1.0);
+    fragColor = VERTEX_COLOR ? color : instanceColor;
+}
\ No newline at end of file
@@ -1,13 +1,18 @@
 
 #include "simple_render_system.hpp"
+#include "lard_swap_chain.hpp"
+#include "lard_uploader.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cassert>
+#include <chrono>
 #include <stdexcept>
 
 
@@ -19,14 +24,91 @@ namespace lard {
         alignas(16) glm::vec3 color;
     };
 
+    // vertex binding 1 of simple_shader_instanced.vert, one per object
+    struct SimpleInstanceData {
+        glm::mat2 transform;
+        glm::vec2 offset;
+        glm::vec3 color;
+    };
+
+    // std430 layouts of cull_objects.comp and simple_shader_indirect.vert
+    struct GpuObjectData {
+        glm::mat2 transform;
+        glm::vec2 offset;
+        alignas(16) glm::vec3 color;
+        uint32_t model;
+    };
+    static_assert(sizeof(GpuObjectData) == 48, "GpuObjectData must match the std430 ObjectData");
+
+    struct GpuModelData {
+        glm::vec2 boundsMin;
+        glm::vec2 boundsMax;
+        uint32_t elementCount;
+        uint32_t indexed;
+        uint32_t firstCommand;
+        uint32_t padding;
+    };
+
+    // std430 layout of animate_objects.comp's ObjectState
+    struct GpuObjectState {
+        glm::vec2 translation;
+        glm::vec2 scale;
+        float rotation;
+        float rotationSpeed;
+        glm::vec2 swayAmplitude;
+        alignas(16) glm::vec3 color;
+        uint32_t model;
+        float swaySpeed;
+        float pulseAmount;
+        float pulseSpeed;
+        float padding;
+    };
+    static_assert(sizeof(GpuObjectState) == 64, "GpuObjectState must match the std430 ObjectState");
+
+    // shared by animate_objects.comp and cull_objects.comp
+    struct ComputePushConstantData {
+        uint32_t objectCount;
+        float time;
+    };
+
+    // local_size_x of both compute shaders
+    constexpr uint32_t COMPUTE_GROUP_SIZE = 64;
+
 
-    SimpleRenderSystem::SimpleRenderSystem(LardDevice& device, VkRenderPass renderPass) : lardDevice{ device } {
+    SimpleRenderSystem::SimpleRenderSystem(
+        LardDevice& device,
+        const LardRenderTargetInfo& renderTarget,
+        LardPipelineRegistry& registry,
+        bool waitForPipeline,
+        uint32_t variant)
+        : lardDevice{ device }, pipelineRegistry{ registry }, renderTarget{ renderTarget }, variant{ variant },
+        staticCommands{ device, LardSwapChain::MAX_FRAMES_IN_FLIGHT } {
         createPipelineLayout();
-        createPipeline(renderPass);
+        lardPipeline = acquirePipeline(variant, PipelineKind::PerObject);
+        if (waitForPipeline) {
+            lardPipeline.wait();
+            if (lardPipeline.hasFailed()) {
+                throw std::runtime_error(lardPipeline.getError());
+            }
+        }
     }
 
     SimpleRenderSystem::~SimpleRenderSystem() {
-        vkDestroyPipelineLayout(lardDevice.device(), pipelineLayout, nullptr);
+        for (auto& frame : indirectFrames) {
+            if (frame.objectBuffer != VK_NULL_HANDLE) {
+                lardDevice.deferDestroyBuffer(frame.objectBuffer, frame.objectAllocation);
+                lardDevice.deferDestroyBuffer(frame.commandBuffer, frame.commandAllocation);
+                lardDevice.deferDestroyBuffer(frame.countBuffer, frame.countAllocation);
+            }
+        }
+        if (stateBuffer != VK_NULL_HANDLE) {
+            lardDevice.deferDestroyBuffer(stateBuffer, stateAllocation, stateUploadToken);
+        }
+        if (descriptorPool != VK_NULL_HANDLE) {
+            VkDevice device = lardDevice.device();
+            VkDescriptorPool pool = descriptorPool;
+            lardDevice.deferDestroy([device, pool]() { vkDestroyDescriptorPool(device, pool, nullptr); });
+        }
     }
 
     void SimpleRenderSystem::createPipelineLayout() {
@@ -35,51 +117,587 @@ namespace lard {
         pushConstantRange.offset = 0;
         pushConstantRange.size = sizeof(SimplePushConstantData);
 
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = 0;
-        pipelineLayoutInfo.pSetLayouts = nullptr;
-        pipelineLayoutInfo.pushConstantRangeCount = 1;
-        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
-        if (vkCreatePipelineLayout(lardDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
-            throw std::runtime_error("Failed to create pipeline layout!");
-        }
+        pipelineLayout = pipelineRegistry.getPipelineLayout({ pushConstantRange });
     }
 
-    void SimpleRenderSystem::createPipeline(VkRenderPass renderPass) {
+    LardPipelineRef SimpleRenderSystem::acquirePipeline(uint32_t variant, PipelineKind kind) {
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
         PipelineConfigInfo pipelineConfig{};
         LardPipeline::defaultPipelineConfigInfo(pipelineConfig);
-        pipelineConfig.renderPass = renderPass;
+        renderTarget.apply(pipelineConfig);
         pipelineConfig.pipelineLayout = pipelineLayout;
-        lardPipeline = std::make_unique<LardPipeline>(
-            lardDevice,
-            "shaders/simple_shader.vert.spv",
-            "shaders/simple_shader.frag.spv",
-            pipelineConfig);
+        // constant IDs match simple_shader's constant_id layout qualifiers
+        pipelineConfig.specialization.set(0, (variant & VARIANT_VERTEX_COLOR) != 0);
+        if (kind == PipelineKind::PerObject) {
+            return pipelineRegistry.acquire("simple_shader.vert", "simple_shader.frag", pipelineConfig);
+        }
+        if (kind == PipelineKind::Indirect) {
+            // objects are read from the storage buffer the culling shader read
+            pipelineConfig.pipelineLayout = indirectPipelineLayout;
+            return pipelineRegistry.acquire("simple_shader_indirect.vert", "simple_shader.frag", pipelineConfig);
+        }
+
+        // specialization cannot remove vertex inputs, so instancing is a shader of its own
+        VkVertexInputBindingDescription instanceBinding{};
+        instanceBinding.binding = 1;
+        instanceBinding.stride = sizeof(SimpleInstanceData);
+        instanceBinding.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE;
+        pipelineConfig.bindingDescriptions.push_back(instanceBinding);
+
+        // the mat2 takes one location per column
+        const std::array<VkVertexInputAttributeDescription, 4> instanceAttributes{ {
+            { 2, 1, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(SimpleInstanceData, transform)) },
+            { 3, 1, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(SimpleInstanceData, transform) + sizeof(glm::vec2)) },
+            { 4, 1, VK_FORMAT_R32G32_SFLOAT, static_cast<uint32_t>(offsetof(SimpleInstanceData, offset)) },
+            { 5, 1, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(SimpleInstanceData, color)) },
+        } };
+        pipelineConfig.attributeDescriptions.insert(
+            pipelineConfig.attributeDescriptions.end(), instanceAttributes.begin(), instanceAttributes.end());
+        return pipelineRegistry.acquire("simple_shader_instanced.vert", "simple_shader.frag", pipelineConfig);
     }
 
-    void SimpleRenderSystem::renderGameObjects(VkCommandBuffer commandBuffer, std::vector<LardGameObject>& gameObjects) {
-        int i = 0;
-        for (auto& obj : gameObjects) {
-            i += 1;
-            obj.transform2d.rotation = glm::mod<float>(obj.transform2d.rotation + 0.0001f * i, 2.f * glm::pi<float>());
+    void SimpleRenderSystem::setVariant(uint32_t newVariant) {
+        if (newVariant == variant) {
+            pendingPipeline.reset();
+            return;
+        }
+        variant = newVariant;
+        pendingPipeline = acquirePipeline(variant, PipelineKind::PerObject);
+        if (instancedPipeline) {
+            pendingInstancedPipeline = acquirePipeline(variant, PipelineKind::Instanced);
         }
+        if (indirectPipeline) {
+            pendingIndirectPipeline = acquirePipeline(variant, PipelineKind::Indirect);
+        }
+    }
 
-        lardPipeline->bind(commandBuffer);
+    static bool promotePipeline(LardPipelineRef& current, LardPipelineRef& pending) {
+        if (!pending || (!pending.isReady() && !pending.hasFailed())) {
+            return false;
+        }
+        if (pending.hasFailed()) {
+            // keep drawing with the previous variant
+            pending.reset();
+            return false;
+        }
+        current = std::move(pending);
+        return true;
+    }
 
-        for (auto& obj : gameObjects) {
-            obj.transform2d.rotation = glm::mod(obj.transform2d.rotation + 0.001f, glm::two_pi<float>());
+    bool SimpleRenderSystem::updatePipeline() {
+        promotePipeline(instancedPipeline, pendingInstancedPipeline);
+        promotePipeline(indirectPipeline, pendingIndirectPipeline);
+        return promotePipeline(lardPipeline, pendingPipeline);
+    }
+
+    void SimpleRenderSystem::updateGameObjects(LardEntityStore& entities) {
+        // only the rotations are streamed
+        auto rotations = entities.rotations();
+        for (size_t i = 0; i < rotations.size(); i++) {
+            float rotation = glm::mod<float>(rotations[i] + 0.0001f * (i + 1), 2.f * glm::pi<float>());
+            rotations[i] = glm::mod(rotation + 0.001f, glm::two_pi<float>());
+        }
+    }
+
+    bool SimpleRenderSystem::recordGameObjects(VkCommandBuffer commandBuffer, const LardEntityStore& entities, size_t begin, size_t end) {
+        LardPipeline* pipeline = lardPipeline.get();
+        if (pipeline == nullptr) {
+            return false;
+        }
+        pipeline->bind(commandBuffer);
+
+        auto models = entities.models();
+        auto translations = entities.translations();
+        auto scales = entities.scales();
+        auto rotations = entities.rotations();
+        auto colors = entities.colors();
+        bool complete = true;
+        LardModel* boundModel = nullptr;
+        for (size_t i = begin; i < end; i++) {
+            LardModel* model = entities.getModel(models[i]);
+            if (!model->isReady()) {
+                complete = false;
+                continue;
+            }
 
             SimplePushConstantData push{};
-            push.offset = obj.transform2d.translation;
-            push.color = obj.color;
-            push.transform = obj.transform2d.mat2();
+            push.offset = translations[i];
+            push.color = colors[i];
+            push.transform = Transform2dComponent::matrix(rotations[i], scales[i]);
 
             vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
-            obj.model->bind(commandBuffer);
-            obj.model->draw(commandBuffer);
+            // runs of the same model keep their buffers bound
+            if (model != boundModel) {
+                model->bind(commandBuffer);
+                boundModel = model;
+            }
+            model->draw(commandBuffer);
+        }
+        return complete;
+    }
+
+    void SimpleRenderSystem::groupByModel(
+        const LardEntityStore& entities,
+        std::vector<InstanceGroup>& groups,
+        std::vector<uint32_t>& groupIndices) {
+        // groupIndices is indexed by model handle
+        groups.clear();
+        groupIndices.assign(entities.getModelSlotCount(), NO_GROUP);
+        for (auto handle : entities.models()) {
+            uint32_t& group = groupIndices[handle];
+            if (group == NO_GROUP) {
+                group = static_cast<uint32_t>(groups.size());
+                groups.push_back({ entities.getModel(handle), 0, 0 });
+            }
+            groups[group].instanceCount++;
+        }
+
+        uint32_t firstInstance = 0;
+        for (auto& group : groups) {
+            group.firstInstance = firstInstance;
+            firstInstance += group.instanceCount;
+        }
+    }
+
+    bool SimpleRenderSystem::prepareInstances(LardFrameAllocator& allocator, const LardEntityStore& entities) {
+        if (!instancedPipeline) {
+            instancedPipeline = acquirePipeline(variant, PipelineKind::Instanced);
         }
+        if (!instancedPipeline.isReady() || entities.empty()) {
+            return false;
+        }
+
+        groupByModel(entities, instanceGroups, instanceGroupIndices);
+        instanceCursors.resize(instanceGroups.size());
+        for (size_t i = 0; i < instanceGroups.size(); i++) {
+            instanceCursors[i] = instanceGroups[i].firstInstance;
+        }
+
+        // then place every object's data in its model's run
+        instanceBuffer = allocator.allocateVertex(entities.size() * sizeof(SimpleInstanceData));
+        auto instances = static_cast<SimpleInstanceData*>(instanceBuffer.data);
+        auto models = entities.models();
+        auto translations = entities.translations();
+        auto scales = entities.scales();
+        auto rotations = entities.rotations();
+        auto colors = entities.colors();
+        for (size_t i = 0; i < entities.size(); i++) {
+            SimpleInstanceData& instance = instances[instanceCursors[instanceGroupIndices[models[i]]]++];
+            instance.transform = Transform2dComponent::matrix(rotations[i], scales[i]);
+            instance.offset = translations[i];
+            instance.color = colors[i];
+        }
+        return true;
+    }
+
+    bool SimpleRenderSystem::recordInstances(VkCommandBuffer commandBuffer, size_t begin, size_t end) {
+        instancedPipeline.get()->bind(commandBuffer);
+        vkCmdBindVertexBuffers(commandBuffer, 1, 1, &instanceBuffer.buffer, &instanceBuffer.offset);
+
+        bool complete = true;
+        for (const auto& group : instanceGroups) {
+            size_t first = std::max<size_t>(begin, group.firstInstance);
+            size_t last = std::min<size_t>(end, group.firstInstance + group.instanceCount);
+            if (first >= last) {
+                continue;
+            }
+            if (!group.model->isReady()) {
+                complete = false;
+                continue;
+            }
+            group.model->bind(commandBuffer);
+            group.model->draw(commandBuffer, static_cast<uint32_t>(last - first), static_cast<uint32_t>(first));
+        }
+        return complete;
+    }
+
+    void SimpleRenderSystem::renderGameObjects(
+        VkCommandBuffer commandBuffer,
+        LardEntityStore& entities,
+        LardFrameAllocator* instanceAllocator) {
+        updatePipeline();
+        updateGameObjects(entities);
+        if (instanceAllocator != nullptr && prepareInstances(*instanceAllocator, entities)) {
+            recordInstances(commandBuffer, 0, entities.size());
+            return;
+        }
+        recordGameObjects(commandBuffer, entities, 0, entities.size());
+    }
+
+    void SimpleRenderSystem::renderGameObjectsParallel(
+        LardCommandRecorder& recorder,
+        VkCommandBuffer commandBuffer,
+        const LardSecondaryInheritance& inheritance,
+        LardEntityStore& entities,
+        LardFrameAllocator* instanceAllocator) {
+        // before the workers start, they only read the pipelines and instance groups
+        updatePipeline();
+        updateGameObjects(entities);
+        if (instanceAllocator != nullptr && prepareInstances(*instanceAllocator, entities)) {
+            // a chunk is just a few draws here, keep them large
+            recorder.recordParallel(commandBuffer, inheritance, entities.size(),
+                [this](VkCommandBuffer secondary, size_t begin, size_t end) {
+                    recordInstances(secondary, begin, end);
+                },
+                std::max<size_t>(LardCommandRecorder::DEFAULT_MIN_CHUNK_SIZE, entities.size() / recorder.threadCount()));
+            return;
+        }
+        recorder.recordParallel(commandBuffer, inheritance, entities.size(),
+            [this, &entities](VkCommandBuffer secondary, size_t begin, size_t end) {
+                recordGameObjects(secondary, entities, begin, end);
+            });
+    }
+
+    void SimpleRenderSystem::createIndirectResources() {
+        // only the objects are read while drawing
+        objectSetLayout = pipelineRegistry.getDescriptorSetLayout({
+            { 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT, nullptr },
+            { 1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+            { 2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+            { 3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+            { 4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr },
+        });
+
+        // one layout for the compute and the drawing pipelines, the set is bound once for all
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(ComputePushConstantData);
+        indirectPipelineLayout = pipelineRegistry.getPipelineLayout({ pushConstantRange }, { objectSetLayout });
+
+        animatePipeline = std::make_unique<LardComputePipeline>(lardDevice, "animate_objects.comp", indirectPipelineLayout);
+        cullPipeline = std::make_unique<LardComputePipeline>(lardDevice, "cull_objects.comp", indirectPipelineLayout);
+        indirectPipeline = acquirePipeline(variant, PipelineKind::Indirect);
+
+        VkDescriptorPoolSize poolSize{};
+        poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSize.descriptorCount = 5 * LardSwapChain::MAX_FRAMES_IN_FLIGHT;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.maxSets = LardSwapChain::MAX_FRAMES_IN_FLIGHT;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        if (vkCreateDescriptorPool(lardDevice.device(), &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create descriptor pool!");
+        }
+
+        indirectFrames.resize(LardSwapChain::MAX_FRAMES_IN_FLIGHT);
+        std::vector<VkDescriptorSetLayout> setLayouts(indirectFrames.size(), objectSetLayout);
+        std::vector<VkDescriptorSet> descriptorSets(indirectFrames.size());
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = descriptorPool;
+        allocInfo.descriptorSetCount = static_cast<uint32_t>(setLayouts.size());
+        allocInfo.pSetLayouts = setLayouts.data();
+        if (vkAllocateDescriptorSets(lardDevice.device(), &allocInfo, descriptorSets.data()) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate descriptor sets!");
+        }
+        for (size_t i = 0; i < indirectFrames.size(); i++) {
+            indirectFrames[i].descriptorSet = descriptorSets[i];
+        }
+    }
+
+    void SimpleRenderSystem::reserveIndirectFrame(IndirectFrame& frame, uint32_t objectCount, uint32_t modelCount) {
+        // grows by doubling, the old buffers may still be read by the slot's previous frame
+        if (objectCount > frame.objectCapacity) {
+            if (frame.objectBuffer != VK_NULL_HANDLE) {
+                lardDevice.deferDestroyBuffer(frame.objectBuffer, frame.objectAllocation);
+            }
+            frame.objectCapacity = std::max(objectCount, 2 * frame.objectCapacity);
+            lardDevice.createBuffer(
+                frame.objectCapacity * sizeof(GpuObjectData),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                frame.objectBuffer,
+                frame.objectAllocation);
+        }
+        // every object may be visible
+        if (objectCount > frame.commandCapacity) {
+            if (frame.commandBuffer != VK_NULL_HANDLE) {
+                lardDevice.deferDestroyBuffer(frame.commandBuffer, frame.commandAllocation);
+            }
+            frame.commandCapacity = std::max(objectCount, 2 * frame.commandCapacity);
+            lardDevice.createBuffer(
+                frame.commandCapacity * sizeof(VkDrawIndexedIndirectCommand),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                frame.commandBuffer,
+                frame.commandAllocation);
+        }
+        if (modelCount > frame.countCapacity) {
+            if (frame.countBuffer != VK_NULL_HANDLE) {
+                lardDevice.deferDestroyBuffer(frame.countBuffer, frame.countAllocation);
+            }
+            frame.countCapacity = std::max(modelCount, 2 * frame.countCapacity);
+            lardDevice.createBuffer(
+                frame.countCapacity * sizeof(uint32_t),
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                frame.countBuffer,
+                frame.countAllocation);
+        }
+    }
+
+    void SimpleRenderSystem::uploadGpuObjects(const LardEntityStore& entities) {
+        groupByModel(entities, indirectGroups, indirectGroupIndices);
+
+        std::vector<GpuObjectState> states(entities.size());
+        auto models = entities.models();
+        auto translations = entities.translations();
+        auto scales = entities.scales();
+        auto rotations = entities.rotations();
+        auto colors = entities.colors();
+        auto animations = entities.animations();
+        for (size_t i = 0; i < entities.size(); i++) {
+            auto& state = states[i];
+            state.translation = translations[i];
+            state.scale = scales[i];
+            state.rotation = rotations[i];
+            state.rotationSpeed = animations[i].rotationSpeed;
+            state.swayAmplitude = animations[i].swayAmplitude;
+            state.color = colors[i];
+            state.model = indirectGroupIndices[models[i]];
+            state.swaySpeed = animations[i].swaySpeed;
+            state.pulseAmount = animations[i].pulseAmount;
+            state.pulseSpeed = animations[i].pulseSpeed;
+            state.padding = 0.f;
+        }
+
+        // a new buffer each time, frames in flight keep reading the old one
+        if (stateBuffer != VK_NULL_HANDLE) {
+            lardDevice.deferDestroyBuffer(stateBuffer, stateAllocation, stateUploadToken);
+        }
+        VkDeviceSize bufferSize = sizeof(GpuObjectState) * states.size();
+        lardDevice.createBuffer(
+            bufferSize,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            stateBuffer,
+            stateAllocation);
+        stateUploadToken = lardDevice.uploader().uploadBuffer(stateBuffer, 0, states.data(), bufferSize);
+
+        uploadedVersion = entities.getVersion();
+        uploadedObjectCount = entities.size();
+        gpuObjectsDirty = false;
+    }
+
+    bool SimpleRenderSystem::cullGameObjects(
+        VkCommandBuffer commandBuffer,
+        uint32_t frameIndex,
+        LardFrameAllocator& allocator,
+        LardEntityStore& entities) {
+        updatePipeline();
+        culledFrame = nullptr;
+        if (!lardDevice.hasIndirectCount()) {
+            // drawn one by one, animated on the CPU as before
+            updateGameObjects(entities);
+            return false;
+        }
+        if (entities.empty()) {
+            return false;
+        }
+        if (!cullPipeline) {
+            createIndirectResources();
+        }
+        // versions are unique across stores, a different or rebuilt store never matches
+        if (gpuObjectsDirty || entities.getVersion() != uploadedVersion) {
+            uploadGpuObjects(entities);
+        }
+        if (!indirectPipeline.isReady() || !lardDevice.uploader().isComplete(stateUploadToken)) {
+            return false;
+        }
+
+        auto objectCount = static_cast<uint32_t>(uploadedObjectCount);
+        auto modelCount = static_cast<uint32_t>(indirectGroups.size());
+        auto& frame = indirectFrames[frameIndex];
+        reserveIndirectFrame(frame, objectCount, modelCount);
+
+        // the only per frame data the CPU writes, one entry per model
+        auto modelBuffer = allocator.allocateStorage(modelCount * sizeof(GpuModelData));
+        auto models = static_cast<GpuModelData*>(modelBuffer.data);
+        for (uint32_t i = 0; i < modelCount; i++) {
+            const auto& group = indirectGroups[i];
+            models[i].boundsMin = group.model->getBoundsMin();
+            models[i].boundsMax = group.model->getBoundsMax();
+            models[i].elementCount = group.model->isIndexed() ? group.model->getIndexCount() : group.model->getVertexCount();
+            models[i].indexed = group.model->isIndexed() ? 1 : 0;
+            models[i].firstCommand = group.firstInstance;
+            models[i].padding = 0;
+        }
+
+        // the slot's previous frame has retired, its set can be rewritten
+        const std::array<VkDescriptorBufferInfo, 5> bufferInfos{ {
+            { frame.objectBuffer, 0, objectCount * sizeof(GpuObjectData) },
+            { modelBuffer.buffer, modelBuffer.offset, modelCount * sizeof(GpuModelData) },
+            { frame.commandBuffer, 0, objectCount * sizeof(VkDrawIndexedIndirectCommand) },
+            { frame.countBuffer, 0, modelCount * sizeof(uint32_t) },
+            { stateBuffer, 0, objectCount * sizeof(GpuObjectState) },
+        } };
+        std::array<VkWriteDescriptorSet, 5> writes{};
+        for (uint32_t i = 0; i < writes.size(); i++) {
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].dstSet = frame.descriptorSet;
+            writes[i].dstBinding = i;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pBufferInfo = &bufferInfos[i];
+        }
+        vkUpdateDescriptorSets(lardDevice.device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+        ComputePushConstantData push{};
+        push.objectCount = objectCount;
+        push.time = std::chrono::duration<float>(std::chrono::steady_clock::now() - animationStart).count();
+        uint32_t groupCount = (objectCount + COMPUTE_GROUP_SIZE - 1) / COMPUTE_GROUP_SIZE;
+
+        vkCmdFillBuffer(commandBuffer, frame.countBuffer, 0, modelCount * sizeof(uint32_t), 0);
+        vkCmdBindDescriptorSets(
+            commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, indirectPipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, indirectPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+        animatePipeline->bind(commandBuffer);
+        vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+
+        // culling reads the animated objects and the cleared counts
+        VkMemoryBarrier2KHR animateBarrier{};
+        animateBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+        animateBarrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        animateBarrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+        animateBarrier.dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        animateBarrier.dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+        VkDependencyInfoKHR dependencyInfo{};
+        dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+        dependencyInfo.memoryBarrierCount = 1;
+        dependencyInfo.pMemoryBarriers = &animateBarrier;
+        lardDevice.cmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+        cullPipeline->bind(commandBuffer);
+        vkCmdDispatch(commandBuffer, groupCount, 1, 1);
+
+        // the draws read the commands and counts, their vertex shader the objects
+        VkMemoryBarrier2KHR cullBarrier{};
+        cullBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+        cullBarrier.srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT;
+        cullBarrier.srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+        cullBarrier.dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT;
+        cullBarrier.dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+        dependencyInfo.pMemoryBarriers = &cullBarrier;
+        lardDevice.cmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+        culledFrame = &frame;
+        return true;
+    }
+
+    void SimpleRenderSystem::renderGameObjectsIndirect(VkCommandBuffer commandBuffer, const LardEntityStore& entities) {
+        if (culledFrame == nullptr) {
+            // not animated unless the device lacks indirect count support, the GPU path takes
+            // over within a few frames otherwise
+            recordGameObjects(commandBuffer, entities, 0, entities.size());
+            return;
+        }
+
+        indirectPipeline.get()->bind(commandBuffer);
+        vkCmdBindDescriptorSets(
+            commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, indirectPipelineLayout, 0, 1, &culledFrame->descriptorSet, 0, nullptr);
+        // one draw per model however many objects there are, the GPU supplies the count
+        for (uint32_t i = 0; i < indirectGroups.size(); i++) {
+            const auto& group = indirectGroups[i];
+            if (!group.model->isReady()) {
+                continue;
+            }
+            group.model->bind(commandBuffer);
+            VkDeviceSize commandOffset = group.firstInstance * sizeof(VkDrawIndexedIndirectCommand);
+            VkDeviceSize countOffset = i * sizeof(uint32_t);
+            if (group.model->isIndexed()) {
+                vkCmdDrawIndexedIndirectCount(
+                    commandBuffer, culledFrame->commandBuffer, commandOffset, culledFrame->countBuffer, countOffset,
+                    group.instanceCount, sizeof(VkDrawIndexedIndirectCommand));
+            } else {
+                vkCmdDrawIndirectCount(
+                    commandBuffer, culledFrame->commandBuffer, commandOffset, culledFrame->countBuffer, countOffset,
+                    group.instanceCount, sizeof(VkDrawIndexedIndirectCommand));
+            }
+        }
+    }
+
+    void SimpleRenderSystem::renderStaticGameObjects(
+        VkCommandBuffer commandBuffer,
+        uint32_t frameIndex,
+        const LardSecondaryInheritance& inheritance,
+        const LardEntityStore& entities) {
+        if (updatePipeline()) {
+            staticCommands.invalidate();
+        }
+        bool complete = true;
+        staticCommands.execute(commandBuffer, frameIndex, inheritance,
+            [this, &entities, &complete](VkCommandBuffer secondary) {
+                complete = recordGameObjects(secondary, entities, 0, entities.size());
+            });
+        // objects skipped while their model uploaded show up once the slots are recorded again
+        if (!complete) {
+            staticCommands.invalidate();
+        }
+    }
+
+    void SimpleRenderSystem::addRenderPass(
+        LardRenderGraph& graph,
+        LardRenderGraph::ResourceId color,
+        LardRenderGraph::ResourceId depth,
+        VkClearColorValue clearColor,
+        LardEntityStore& entities,
+        LardCommandRecorder* recorder,
+        LardFrameAllocator* instanceAllocator) {
+        graph.addPass(
+            "simple render system",
+            [&](LardRenderGraph::PassBuilder& builder) {
+                builder.writeColor(color, clearColor);
+                builder.writeDepth(depth, { 1.0f, 0 });
+                if (recorder != nullptr) {
+                    builder.setSecondaryCommandBuffers();
+                }
+            },
+            [this, &entities, recorder, instanceAllocator](VkCommandBuffer commandBuffer, const LardRenderGraph& graph) {
+                if (recorder != nullptr) {
+                    renderGameObjectsParallel(*recorder, commandBuffer, graph.getSecondaryInheritance(), entities, instanceAllocator);
+                } else {
+                    renderGameObjects(commandBuffer, entities, instanceAllocator);
+                }
+            });
+    }
+
+    void SimpleRenderSystem::addIndirectRenderPass(
+        LardRenderGraph& graph,
+        LardRenderGraph::ResourceId color,
+        LardRenderGraph::ResourceId depth,
+        VkClearColorValue clearColor,
+        const LardEntityStore& entities) {
+        graph.addPass(
+            "simple render system (indirect)",
+            [&](LardRenderGraph::PassBuilder& builder) {
+                builder.writeColor(color, clearColor);
+                builder.writeDepth(depth, { 1.0f, 0 });
+            },
+            [this, &entities](VkCommandBuffer commandBuffer, const LardRenderGraph&) {
+                renderGameObjectsIndirect(commandBuffer, entities);
+            });
+    }
+
+    void SimpleRenderSystem::addStaticRenderPass(
+        LardRenderGraph& graph,
+        LardRenderGraph::ResourceId color,
+        LardRenderGraph::ResourceId depth,
+        VkClearColorValue clearColor,
+        uint32_t frameIndex,
+        const LardEntityStore& entities) {
+        graph.addPass(
+            "simple render system (static)",
+            [&](LardRenderGraph::PassBuilder& builder) {
+                builder.writeColor(color, clearColor);
+                builder.writeDepth(depth, { 1.0f, 0 });
+                builder.setSecondaryCommandBuffers();
+            },
+            [this, &entities, frameIndex](VkCommandBuffer commandBuffer, const LardRenderGraph& graph) {
+                renderStaticGameObjects(commandBuffer, frameIndex, graph.getSecondaryInheritance(), entities);
+            });
     }
 }
\ No newline at end of file
@@ -1,27 +1,194 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <vector>
 
-#include "lard_game_object.hpp"
+#include "lard_entity_store.hpp"
 #include "lard_pipeline.hpp"
+#include "lard_pipeline_registry.hpp"
+#include "lard_command_recorder.hpp"
+#include "lard_compute_pipeline.hpp"
 #include "lard_device.hpp"
+#include "lard_frame_allocator.hpp"
+#include "lard_render_graph.hpp"
+#include "lard_static_commands.hpp"
 
 namespace lard {
     class SimpleRenderSystem {
     public:
-        SimpleRenderSystem(LardDevice& device, VkRenderPass renderPass);
+        // variant bits, each one a specialization constant of simple_shader
+        static constexpr uint32_t VARIANT_VERTEX_COLOR = 1 << 0;  // vertex colors, not push colors
+
+        // the pipeline and its layout come from registry, shared with identical systems; unless
+        // waitForPipeline it may still be compiling afterwards and nothing is drawn until it is ready
+        SimpleRenderSystem(
+            LardDevice& device,
+            const LardRenderTargetInfo& renderTarget,
+            LardPipelineRegistry& registry,
+            bool waitForPipeline = true,
+            uint32_t variant = 0);
         ~SimpleRenderSystem();
         SimpleRenderSystem(const SimpleRenderSystem&) = delete;
         SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
-        void renderGameObjects(VkCommandBuffer commandBuffer, std::vector<LardGameObject>& gameObjects);
+        // With instanceAllocator, objects sharing a model are drawn with one instanced draw, their
+        // transforms and colors written to an instance buffer from it. Until the instanced
+        // pipeline has compiled objects are drawn one by one.
+        void renderGameObjects(
+            VkCommandBuffer commandBuffer,
+            LardEntityStore& entities,
+            LardFrameAllocator* instanceAllocator = nullptr);
+        // draws chunks of entities into secondary buffers on the recorder's threads, the
+        // render pass instance must have been begun with secondary contents
+        void renderGameObjectsParallel(
+            LardCommandRecorder& recorder,
+            VkCommandBuffer commandBuffer,
+            const LardSecondaryInheritance& inheritance,
+            LardEntityStore& entities,
+            LardFrameAllocator* instanceAllocator = nullptr);
+        // draws entities without animating them, from a secondary buffer recorded once per
+        // frame slot; the render pass instance must have been begun with secondary contents
+        void renderStaticGameObjects(
+            VkCommandBuffer commandBuffer,
+            uint32_t frameIndex,
+            const LardSecondaryInheritance& inheritance,
+            const LardEntityStore& entities);
+        // call after changing the objects passed to renderStaticGameObjects
+        void invalidateStaticGameObjects() { staticCommands.invalidate(); }
+        LardStaticCommands::Stats getStaticStats() const { return staticCommands.getStats(); }
+        // GPU driven drawing, outside any render pass: one compute shader evaluates every object's
+        // AnimationComponent, a second culls the results against the viewport and writes one
+        // indirect draw per visible object. entities are uploaded to a device local buffer the
+        // first time and again after invalidateGpuObjects(), otherwise the CPU does not touch them.
+        // False if nothing was dispatched because the device lacks indirect count support, or
+        // the pipelines are still compiling or the objects still uploading.
+        bool cullGameObjects(
+            VkCommandBuffer commandBuffer,
+            uint32_t frameIndex,
+            LardFrameAllocator& allocator,
+            LardEntityStore& entities);
+        // draws what the last cullGameObjects left visible with one indirect count draw per model,
+        // the same entities one by one if it dispatched nothing
+        void renderGameObjectsIndirect(VkCommandBuffer commandBuffer, const LardEntityStore& entities);
+        // call after writing to the components of the entities passed to cullGameObjects, adding
+        // and removing entities is noticed on its own
+        void invalidateGpuObjects() { gpuObjectsDirty = true; }
+        bool isPipelineReady() const { return lardPipeline.isReady(); }
+        // switches to another shader variant, the current one keeps drawing until it has compiled
+        void setVariant(uint32_t variant);
+        uint32_t getVariant() const { return variant; }
+        // clears color and depth and draws entities into them, in parallel when recorder is
+        // set; entities must outlive the frame's recording
+        void addRenderPass(
+            LardRenderGraph& graph,
+            LardRenderGraph::ResourceId color,
+            LardRenderGraph::ResourceId depth,
+            VkClearColorValue clearColor,
+            LardEntityStore& entities,
+            LardCommandRecorder* recorder = nullptr,
+            LardFrameAllocator* instanceAllocator = nullptr);
+        // like addRenderPass but draws with renderGameObjectsIndirect, cullGameObjects must have
+        // been recorded before the graph executes
+        void addIndirectRenderPass(
+            LardRenderGraph& graph,
+            LardRenderGraph::ResourceId color,
+            LardRenderGraph::ResourceId depth,
+            VkClearColorValue clearColor,
+            const LardEntityStore& entities);
+        // like addRenderPass but draws entities with renderStaticGameObjects
+        void addStaticRenderPass(
+            LardRenderGraph& graph,
+            LardRenderGraph::ResourceId color,
+            LardRenderGraph::ResourceId depth,
+            VkClearColorValue clearColor,
+            uint32_t frameIndex,
+            const LardEntityStore& entities);
 
     private:
+        static constexpr uint32_t NO_GROUP = ~0u;
+
+        struct InstanceGroup {
+            LardModel* model;
+            uint32_t firstInstance;
+            uint32_t instanceCount;
+        };
+
+        // per frame slot, device local and only written by the culling shader
+        struct IndirectFrame {
+            VkBuffer objectBuffer = VK_NULL_HANDLE;  // animated transforms
+            LardAllocation objectAllocation{};
+            uint32_t objectCapacity = 0;
+            VkBuffer commandBuffer = VK_NULL_HANDLE;
+            LardAllocation commandAllocation{};
+            uint32_t commandCapacity = 0;
+            VkBuffer countBuffer = VK_NULL_HANDLE;
+            LardAllocation countAllocation{};
+            uint32_t countCapacity = 0;
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        };
+
+        enum class PipelineKind { PerObject, Instanced, Indirect };
+
         void createPipelineLayout();
-        void createPipeline(VkRenderPass renderPass);
+        LardPipelineRef acquirePipeline(uint32_t variant, PipelineKind kind);
+        // created on the first cullGameObjects
+        void createIndirectResources();
+        void reserveIndirectFrame(IndirectFrame& frame, uint32_t objectCount, uint32_t modelCount);
+        // groups entities by model and uploads their state and animation
+        void uploadGpuObjects(const LardEntityStore& entities);
+        // swaps in pending variants once they have compiled, true if the per object pipeline changed
+        bool updatePipeline();
+        void updateGameObjects(LardEntityStore& entities);
+        // one group per model in order of first appearance, with consecutive instance ranges;
+        // groupIndices maps model handles to groups
+        static void groupByModel(
+            const LardEntityStore& entities,
+            std::vector<InstanceGroup>& groups,
+            std::vector<uint32_t>& groupIndices);
+        // only reads entities, safe to call from several threads on disjoint ranges; returns
+        // false if the pipeline is still compiling or a model was still uploading and its object
+        // got skipped
+        bool recordGameObjects(VkCommandBuffer commandBuffer, const LardEntityStore& entities, size_t begin, size_t end);
+        // groups entities by model and writes their instance data, false if the instanced
+        // pipeline is not ready yet
+        bool prepareInstances(LardFrameAllocator& allocator, const LardEntityStore& entities);
+        // draws instances [begin, end) of the last prepareInstances, safe to call from several threads
+        bool recordInstances(VkCommandBuffer commandBuffer, size_t begin, size_t end);
 
         LardDevice& lardDevice;
-        std::unique_ptr<LardPipeline> lardPipeline;
-        VkPipelineLayout pipelineLayout;
+        LardPipelineRegistry& pipelineRegistry;
+        LardRenderTargetInfo renderTarget;
+        uint32_t variant;
+        LardPipelineRef lardPipeline;
+        LardPipelineRef pendingPipeline;  // the variant being switched to
+        // acquired on first instanced use
+        LardPipelineRef instancedPipeline;
+        LardPipelineRef pendingInstancedPipeline;
+        std::vector<InstanceGroup> instanceGroups;
+        std::vector<uint32_t> instanceGroupIndices;
+        std::vector<uint32_t> instanceCursors;
+        LardFrameAllocation instanceBuffer{};
+        VkPipelineLayout pipelineLayout;  // owned by the registry
+        // GPU driven path, its layouts are owned by the registry as well
+        VkDescriptorSetLayout objectSetLayout = VK_NULL_HANDLE;
+        VkPipelineLayout indirectPipelineLayout = VK_NULL_HANDLE;
+        std::unique_ptr<LardComputePipeline> animatePipeline;
+        std::unique_ptr<LardComputePipeline> cullPipeline;
+        LardPipelineRef indirectPipeline;
+        LardPipelineRef pendingIndirectPipeline;
+        VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+        std::vector<IndirectFrame> indirectFrames;
+        IndirectFrame* culledFrame = nullptr;  // what renderGameObjectsIndirect draws from
+        // the uploaded objects, a group's range is where its draws go in the command buffer
+        std::vector<InstanceGroup> indirectGroups;
+        std::vector<uint32_t> indirectGroupIndices;
+        VkBuffer stateBuffer = VK_NULL_HANDLE;
+        LardAllocation stateAllocation{};
+        LardUploadToken stateUploadToken{};
+        uint64_t uploadedVersion = 0;  // of the store uploaded last, 0 before the first upload
+        size_t uploadedObjectCount = 0;
+        bool gpuObjectsDirty = true;
+        std::chrono::steady_clock::time_point animationStart = std::chrono::steady_clock::now();
+        LardStaticCommands staticCommands;
     };
 }
\ No newline at end of file